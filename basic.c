@@ -6,51 +6,235 @@
 
 // Compiler requires description
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 #include <termios.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <stdint.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <dirent.h>
 
 // TOYOSHIKI TinyBASIC symbols
 // TO-DO Rewrite defined values to fit your machine as needed
 #define SIZE_LINE 78 //Command line buffer length + NULL
-#define SIZE_IBUF 78 //i-code conversion buffer size
-#define SIZE_LIST 1024 //List buffer size
-#define SIZE_ARRY 64 //Array area size
-#define SIZE_GSTK 6 //GOSUB stack size(2/nest)
-#define SIZE_LSTK 15 //FOR stack size(5/nest)
+#define SIZE_IBUF (NUM_BITS > 16 ? 255 : 78) //i-code conversion buffer size(<256)
+#define SIZE_LIST 1024 //List buffer size(default of lsize)
+#define SIZE_ARRY 64 //Array area size(default of asize)
+#define SIZE_GSTK 6 //GOSUB stack size(2/nest, default of gsize)
+#define SIZE_LSTK 2 //FOR stack size(nests), grows up to lstkmax
+#define SIZE_TRACE 4096 //Trace records(power of 2)
+#define SIZE_TRERR 16 //Trace records shown by error
+
+// Interpreter state is per thread, so each thread runs its own program
+// (see bopen()). Only the terminal and its signals belong to the process
+#define TLS __thread
+
+// Numeric width
+// Values are NUM_BITS bits, 16 as the original if not defined. Build with
+// -DNUM_BITS=32 or 64 and -fwrapv for wider ones, values wrap around as
+// in 16 bits. Line numbers are 16 bits in any build
+#ifndef NUM_BITS
+#define NUM_BITS 16
+#endif
+#if NUM_BITS == 16
+typedef short num;
+typedef unsigned short unum;
+#define NUM_MAX 32767
+#define NUM_DIGITS 5
+#elif NUM_BITS == 32
+typedef int32_t num;
+typedef uint32_t unum;
+#define NUM_MAX INT32_MAX
+#define NUM_DIGITS 10
+#elif NUM_BITS == 64
+typedef int64_t num;
+typedef uint64_t unum;
+#define NUM_MAX INT64_MAX
+#define NUM_DIGITS 19
+#else
+#error NUM_BITS must be 16, 32 or 64
+#endif
+#define NUM_SIZE (NUM_BITS / 8) //Bytes of constant after I_NUM
+
+// Divide, the smallest value / -1 traps but in 16 bits(int in C)
+#if NUM_BITS == 16
+#define NUM_DIV(a, b) ((a) / (b))
+#else
+#define NUM_DIV(a, b) ((b) == -1 ? 0 - (a) : (a) / (b))
+#endif
 
 // Depending on device functions
 // TO-DO Rewrite these functions to fit your machine
 #define STR_EDITION "LINUX"
 
+// Runtime counters
+// Cheap enough to be always on, shown by STATS and by -j at exit of -r
+typedef struct {
+	unsigned long lookup; //Line searches by number
+	unsigned long scan; //Index entries visited by the searches
+	unsigned short gmax; //Most GOSUB stack used(2/nest)
+	unsigned short fmax; //Most FOR nests
+	unsigned short lpeak; //Most list bytes
+	unsigned long long out; //Bytes written
+	unsigned long long inwait; //Time blocked in input(ns)
+} counter;
+TLS counter ctr; //Runtime counters
+
+// Time in ns
+unsigned long long c_nsec(){
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
 // Terminal control
-#define c_putch(c) putchar(c)
+// Output is buffered, and flushed before input, by newline() on a TTY,
+// on error and at exit
+#define SIZE_OBUF 4096 //Output buffer size
+TLS char obuf[SIZE_OBUF]; //Output buffer
+TLS short obufn; //Output buffer count
+TLS char otty; //Output is a TTY
+TLS int ofd = STDOUT_FILENO; //Output file, stderr for errors in batch mode
+
+// Device of an interpreter other than the terminal
+typedef struct {
+	int (*getch)(void* arg); //Return next input character, EOF at the end
+	int (*write)(void* arg, int fd, const char* s, int n); //Output to fd
+	// (stdout or stderr), return count written like write()
+	void* arg; //Argument to them
+} bdev;
+TLS bdev* dev; //Device, NULL for the terminal
+
+// Write n characters to ofd
+int c_out(const char* s, int n){
+	return dev ? dev->write(dev->arg, ofd, s, n) : write(ofd, s, n);
+}
 
-char c_getch(){
-	struct termios b;
+void c_flush(){
+	short n, k;
+
+	for(n = 0; n < obufn; n += k){
+		k = c_out(obuf + n, obufn - n);
+		if(k <= 0)
+			break;
+		ctr.out += k;
+	}
+	obufn = 0;
+}
+
+#define c_putch(c) do{ if(obufn >= SIZE_OBUF) c_flush(); obuf[obufn++] = (c); }while(0)
+
+// Put n characters at once
+void c_write(const char* s, short n){
+	if(obufn + n > SIZE_OBUF)
+		c_flush();
+	if(n > SIZE_OBUF){
+		n = c_out(s, n);
+		if(n > 0)
+			ctr.out += n;
+		return;
+	}
+	memcpy(obuf + obufn, s, n);
+	obufn += n;
+}
+
+// Input
+// A TTY is in raw mode(no echo, no line edit) for the whole session,
+// restored at exit or by a signal. Other input is read by stdio buffer
+// without echo, and the end of it works as SYSTEM, or an error of INPUT
+#define KEY_ENTER 10
+
+struct termios tsave; //Terminal mode to restore
+TLS char itty; //Input is a TTY in raw mode
+TLS char ieof; //End of input
+
+// Set raw mode
+void c_ttyraw(){
 	struct termios a;
-	char c;
 
-	tcgetattr(STDIN_FILENO, &b);
-	a = b;
+	a = tsave;
 	a.c_lflag &= ~(ICANON | ECHO);
+	a.c_cc[VMIN] = 1;
+	a.c_cc[VTIME] = 0;
 	tcsetattr(STDIN_FILENO, TCSANOW, &a);
-	c = getchar();
-	tcsetattr(STDIN_FILENO, TCSANOW, &b);
+}
+
+// Restore terminal mode
+void c_ttyend(){
+	c_flush();
+	if(itty)
+		tcsetattr(STDIN_FILENO, TCSANOW, &tsave);
+}
+
+// Restore terminal and die by the signal
+void c_ttysig(int sig){
+	c_ttyend();
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
 
+// Restore terminal while stopped
+void c_ttystop(int sig){
+	(void)sig;
+	c_ttyend();
+	signal(SIGTSTP, SIG_DFL);
+	raise(SIGTSTP);
+	signal(SIGTSTP, c_ttystop); // continued
+	c_ttyraw();
+}
+
+// Start input, called once
+void c_ttystart(){
+	itty = isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &tsave) == 0;
+	atexit(c_ttyend);
+	if(!itty)
+		return;
+	signal(SIGINT, c_ttysig);
+	signal(SIGTERM, c_ttysig);
+	signal(SIGHUP, c_ttysig);
+	signal(SIGQUIT, c_ttysig);
+	signal(SIGTSTP, c_ttystop);
+	c_ttyraw();
+}
+
+char c_getch(){
+	unsigned long long t;
+	int c;
+
+	c_flush(); // show prompt and echo
+	t = c_nsec();
+	c = dev ? dev->getch(dev->arg) : getchar();
+	ctr.inwait += c_nsec() - t;
+	if(c == EOF){
+		if(!itty || feof(stdin)) // end of input, finish the line
+			ieof = 1;
+		clearerr(stdin);
+		return KEY_ENTER;
+	}
 	return c;
 }
 
 char c_kbhit(void)
 {
-	char c;
+	int c;
 	int f;
 
+	if(!itty) // keys are not typed
+		return 0;
+
 	f = fcntl(STDIN_FILENO, F_GETFL, 0);
 	fcntl(STDIN_FILENO, F_SETFL, f | O_NONBLOCK);
 
-	c = c_getch();
+	c = getchar();
 
 	fcntl(STDIN_FILENO, F_SETFL, f);
 
@@ -59,21 +243,126 @@ char c_kbhit(void)
 		return 1;
 	}
 
+	clearerr(stdin);
+	return 0;
+}
+
+// Abort key polling
+// SIGALRM raises kbflag every KBHIT_MSEC, iexe() tests only the flag.
+// Only the thread on the terminal runs the timer. A checkpoint request
+// raises it too, see icheck()
+#define KBHIT_MSEC 50 //Abort key check interval(ms)
+TLS volatile sig_atomic_t kbflag; //Abort key check request
+TLS volatile sig_atomic_t ckreq; //Checkpoint request
+TLS unsigned short ckint; //Seconds between checkpoints(-i), 0: none
+TLS unsigned int cktick; //Timer ticks since the last checkpoint
+
+void kbtick(int sig){
+	(void)sig;
+	kbflag = 1;
+	if(ckint && ++cktick >= ckint * (1000 / KBHIT_MSEC)){
+		cktick = 0;
+		ckreq = 1;
+	}
+}
+
+// Request a checkpoint by SIGUSR1
+void cksig(int sig){
+	(void)sig;
+	ckreq = 1;
+	kbflag = 1;
+}
+
+void c_kbstart(){
+	struct sigaction sa;
+	struct itimerval it;
+
+	if(!itty && !ckint) // keys are not typed
+		return;
+
+	sa.sa_handler = kbtick;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART; // Do not break INPUT
+	sigaction(SIGALRM, &sa, NULL);
+
+	kbflag = 1; // Check once at start
+	it.it_interval.tv_sec = 0;
+	it.it_interval.tv_usec = KBHIT_MSEC * 1000;
+	it.it_value = it.it_interval;
+	setitimer(ITIMER_REAL, &it, NULL);
+}
+
+void c_kbstop(){
+	struct itimerval it;
+
+	if(!itty && !ckint)
+		return;
+
+	it.it_interval.tv_sec = 0;
+	it.it_interval.tv_usec = 0;
+	it.it_value = it.it_interval;
+	setitimer(ITIMER_REAL, &it, NULL);
+	kbflag = 0;
+}
+
+// Return 1 if ESC pressed, called when kbflag is set
+char c_kbesc(){
+	kbflag = 0;
+	if (c_kbhit()) // check keyin
+		if (c_getch() == 27) // ESC ?
+			return 1;
 	return 0;
 }
 
-#define KEY_ENTER 10
 void newline(void){
 	c_putch(KEY_ENTER); //LF
+	if(otty)
+		c_flush();
+}
+
+// Random numbers
+// Each interpreter has its own generator, a seed gives the same sequence
+// as srand() and rand(), that is the additive generator of glibc
+#define RND_DEG 31 //Words of the state
+#define RND_SEP 3 //Distance of the taps
+TLS uint32_t rstate[RND_DEG]; //State of RND generator
+TLS unsigned short rstati; //Rear tap, the front is RND_SEP after
+
+// Return the next 31 bits
+int32_t c_rand(void){
+	uint32_t* f = &rstate[(rstati + RND_SEP) % RND_DEG];
+
+	*f += rstate[rstati];
+	rstati = (rstati + 1) % RND_DEG;
+	return *f >> 1;
+}
+
+void c_srand(unsigned int seed){
+	int32_t w = seed ? seed : 1;
+	short i;
+
+	rstate[0] = w;
+	for (i = 1; i < RND_DEG; i++) { // 16807 * w % 2147483647 without overflow
+		w = 16807 * (w % 127773) - 2836 * (w / 127773);
+		if (w < 0)
+			w += 2147483647;
+		rstate[i] = w;
+	}
+	rstati = 0;
+	for (i = 0; i < RND_DEG * 10; i++)
+		c_rand();
 }
 
 // Return random number
-short getrnd(short value){
-        return(rand() % value) + 1;
+num getrnd(num value){
+	return(c_rand() % value) + 1;
 }
 
 // Prototypes (necessity minimum)
-short iexp(void);
+num iexp(void);
+void eclear(void);
+void icheck(void);
+void igo(char resume);
 
 // Keyword table
 const char* kwtbl[] = {
@@ -85,7 +374,8 @@ const char* kwtbl[] = {
 	"-", "+", "*", "/", "(", ")",
 	">=", "#", ">", "=", "<=", "<",
 	 "@", "RND", "ABS", "SIZE",
-	"LIST", "RUN", "NEW", "SYSTEM"
+	"LIST", "RUN", "NEW", "SYSTEM", "JIT", "OPT", "LOAD", "PROFILE", "STATS",
+	"TRON", "TROFF", "TRACE", "SAVE", "CHECKPOINT"
 };
 
 // i-code(Intermediate code) assignment
@@ -98,14 +388,81 @@ enum{
 	I_MINUS, I_PLUS, I_MUL, I_DIV, I_OPEN, I_CLOSE,
 	I_GTE, I_SHARP, I_GT, I_EQ, I_LTE, I_LT,
 	I_ARRAY, I_RND, I_ABS, I_SIZE,
-	I_LIST, I_RUN, I_NEW, I_SYSTEM,
+	I_LIST, I_RUN, I_NEW, I_SYSTEM, I_JIT, I_OPT, I_LOAD, I_PROFILE, I_STATS,
+	I_TRON, I_TROFF, I_TRACE, I_SAVE, I_CHECKPOINT,
 	I_NUM, I_VAR, I_STR,
+	I_LNK, // linked line (made by RUN only)
 	I_EOL
 };
 
+// Instrumented builds
+// Define BENCH to count statements and show the count at exit of -r
+// (bench/), PROFILE to count executions and time of each line(PROFILE).
+// They run on the switch loop of iexe() only, so the numbers are the same
+// whatever the other builds do, and the other builds pay nothing
+#if defined(BENCH) || defined(PROFILE)
+#define NO_VM
+#define NO_THREADED
+#endif
+#ifdef BENCH
+TLS unsigned long nstmt[256]; //Statements executed by i-code
+
+// Return statements executed
+unsigned long nstmts() {
+	unsigned long n = 0;
+	short i;
+
+	for (i = 0; i < 256; i++)
+		n += nstmt[i];
+	return n;
+}
+#endif
+
+// i-code dispatch
+// GCC/Clang use direct threaded code (labels as values) for statements
+// and values, define NO_THREADED to build with portable switch statement.
+// Operator loops in imul()/iplus()/iexp() keep switch, a few compares
+// predict better than one more indirect jump
+#if defined(__GNUC__) && !defined(NO_THREADED)
+#define THREADED
+#endif
+
+#ifdef THREADED
+// Entries override the default of the range, which -Wextra warns about
+#define ITABLE(t, ...) _Pragma("GCC diagnostic push")\
+	_Pragma("GCC diagnostic ignored \"-Woverride-init\"")\
+	static const void* const t[256] = {\
+	[0 ... 255] = &&L_default, __VA_ARGS__ }; /* jump table */\
+	_Pragma("GCC diagnostic pop")
+#define IJUMP(c) [c] = &&L_##c // jump table entry
+#define IDISPATCH(t) goto *t[*cip] // jump to i-code handler
+#define ICASE(c) case c: L_##c // i-code handler
+#define IDEFAULT default: L_default // other i-code handler
+#define INEXT(t) goto *t[*cip] // end of handler, jump to next
+#define VDISPATCH(t) goto *t[*pc++] // jump to operation handler(code)
+#define VNEXT(t) goto *t[*pc++] // end of operation handler, jump to next
+#else
+#define ITABLE(t, ...)
+#define IJUMP(c)
+#define IDISPATCH(t)
+#define ICASE(c) case c
+#define IDEFAULT default
+#define INEXT(t) break
+#define VDISPATCH(t)
+#define VNEXT(t) break
+#endif
+
+// End of statement handler, go to next unless error or abort key check
+#define SNEXT(t) if (err || kbflag) break; else INEXT(t)
+
 // Keyword count
 #define SIZE_KWTBL (sizeof(kwtbl) / sizeof(const char*))
 
+// Return name of statement i-code
+const char* iname(unsigned char c) {
+	return c < SIZE_KWTBL ? kwtbl[c] : c == I_VAR ? "VAR" : "?";
+}
+
 // List formatting condition
 // no space after
 const unsigned char i_nsa[] = {
@@ -135,7 +492,7 @@ char sstyle(unsigned char code, const unsigned char *table, unsigned char count)
 #define nospaceb(c) sstyle(c, i_nsb, sizeof(i_nsb))
 
 // Error messages
-unsigned char err;// Error message index
+TLS unsigned char err;// Error message index
 const char* errmsg[] ={
 	"OK",
 	"Devision by zero",
@@ -159,7 +516,10 @@ const char* errmsg[] ={
 	"Illegal command",
 	"Syntax error",
 	"Internal error",
-	"Abort by [ESC]"
+	"Abort by [ESC]",
+	"File not found",
+	"Bad image",
+	"End of input"
 };
 
 // Error code assignment
@@ -178,21 +538,79 @@ enum{
 	ERR_COM,
 	ERR_SYNTAX,
 	ERR_SYS,
-	ERR_ESC
+	ERR_ESC,
+	ERR_FILE,
+	ERR_IMG,
+	ERR_EOF
 };
 
 // RAM mapping
-char lbuf[SIZE_LINE]; //Command line buffer
-unsigned char ibuf[SIZE_IBUF]; //i-code conversion buffer
-short var[26]; //Variable area
-short arr[SIZE_ARRY]; //Array area
-unsigned char listbuf[SIZE_LIST]; //List area
-unsigned char* clp; //Pointer current line
-unsigned char* cip; //Pointer current Intermediate code
-unsigned char* gstk[SIZE_GSTK]; //GOSUB stack
-unsigned char gstki; //GOSUB stack index
-unsigned char* lstk[SIZE_LSTK]; //FOR stack
-unsigned char lstki; //FOR stack index
+TLS char lbuf[SIZE_LINE]; //Command line buffer
+TLS unsigned char ibuf[SIZE_IBUF]; //i-code conversion buffer
+TLS short lsize = SIZE_LIST; //List buffer size(<32768)
+TLS short asize = SIZE_ARRY; //Array area size
+TLS unsigned short gsize = SIZE_GSTK; //GOSUB stack size(2/nest)
+TLS num var[26]; //Variable area
+TLS num* arr; //Array area
+TLS unsigned char* listbuf; //List area
+TLS unsigned char* lend; //Pointer end of list
+TLS unsigned short* lidx; //Line index(offset, sorted by line number, lsize / 4 + 1)
+TLS short lcnt; //Line count
+TLS unsigned char linked; //List may include I_LNK
+TLS unsigned short jithot; //JIT threshold(jumps back to a loop), 0: JIT off
+TLS unsigned char opt; //Optimizer at RUN, 0: off, 1: on, 2: on and report
+TLS unsigned char* clp; //Pointer current line
+TLS unsigned char* cip; //Pointer current Intermediate code
+TLS unsigned char** gstk; //GOSUB stack
+TLS unsigned short gstki; //GOSUB stack index
+TLS num** gstkp; //VM resume point of GOSUB stack(NULL by iexe, gsize / 2)
+
+// FOR stack frame
+typedef struct {
+	num* vp; //Loop counter
+	num vto; //TO value
+	num vstep; //STEP value
+	num* pc; //VM loop point(NULL by iexe)
+	unsigned char* lp; //Line pointer of loop point
+	unsigned char* ip; //i-code pointer of loop point
+} lframe;
+
+TLS lframe lstk0[SIZE_LSTK]; //FOR stack in place
+TLS lframe* lstk; //FOR stack, lstk0 until grown
+TLS unsigned short lstki; //FOR stack index
+TLS unsigned short lstkn = SIZE_LSTK; //FOR stack size
+TLS unsigned short lstkmax = SIZE_LSTK; //FOR stack size limit
+TLS num rtape[16]; //Last RND values by compiled code
+TLS unsigned char rtapei; //RND tape index
+TLS unsigned char rplay; //RND values to replay from the tape
+TLS unsigned int trbuf[SIZE_TRACE]; //Trace ring(line number << 8 | i-code)
+TLS unsigned long trn; //Trace records made
+TLS unsigned char tron; //Trace on(TRON)
+TLS unsigned short trerr = SIZE_TRERR; //Trace records shown by error()
+
+#ifdef PROFILE
+// Profile of the last RUN, by offset of line in listbuf(lsize)
+TLS unsigned long* pcnt; //Executions(transitions into the line)
+TLS unsigned long long* ptime; //Time(ns) until the next transition
+TLS unsigned char* pline; //Line being timed, NULL if not in RUN
+TLS unsigned long long ptick; //Time of the last transition
+
+// Clear profile
+void pclear() {
+	memset(pcnt, 0, sizeof(unsigned long) * lsize);
+	memset(ptime, 0, sizeof(unsigned long long) * lsize);
+}
+
+// Enter line clp, the time so far goes to the line before
+void pmark() {
+	unsigned long long t = c_nsec();
+
+	ptime[pline - listbuf] += t - ptick;
+	ptick = t;
+	pline = clp;
+	pcnt[clp - listbuf]++;
+}
+#endif
 
 // Standard C libraly (about) same functions
 char c_toupper(char c) {return(c <= 'z' && c >= 'a' ? c - 32 : c);}
@@ -200,7 +618,7 @@ char c_isprint(char c) {return(c >= 32  && c <= 126);}
 char c_isspace(char c) {return(c == ' ' || (c <= 13 && c >= 9));}
 char c_isdigit(char c) {return(c <= '9' && c >= '0');}
 char c_isalpha(char c) {return ((c <= 'z' && c >= 'a') || (c <= 'Z' && c >= 'A'));}
-void c_puts(const char *s) {while(*s) c_putch(*s++);}
+void c_puts(const char *s) {c_write(s, strlen(s));}
 void c_gets(){
 	char c;
 	unsigned char len;
@@ -210,11 +628,14 @@ void c_gets(){
 		if( c == 9) c = ' '; // TAB exchange Space
 		if(((c == 8) || (c == 127)) && (len > 0)){ // Backspace manipulation
 			len--;
-			c_putch(8); c_putch(' '); c_putch(8);
+			if(itty){
+				c_putch(8); c_putch(' '); c_putch(8);
+			}
 		} else
 		if(c_isprint(c) && (len < (SIZE_LINE - 1))){
 			lbuf[len++] = c;
-			c_putch(c);
+			if(itty)
+				c_putch(c); // Echo
 		}
 	}
 	newline();
@@ -227,7 +648,7 @@ void c_gets(){
 }
 
 // Print numeric specified columns
-void putnum(short value, short d){
+void putnum(num value, short d){
 	unsigned char i;
 	unsigned char sign;
 
@@ -238,8 +659,8 @@ void putnum(short value, short d){
 		sign = 0;
 	}
 
-	lbuf[6] = 0;
-	i = 6;
+	lbuf[NUM_DIGITS + 1] = 0;
+	i = NUM_DIGITS + 1;
 	do {
 		lbuf[--i] = (value % 10) + '0';
 		value /= 10;
@@ -248,18 +669,34 @@ void putnum(short value, short d){
 	if(sign)
 		lbuf[--i] = '-';
 
-	//String length = 6 - i
-	while(6 - i < d){ // If short
+	//String length = NUM_DIGITS + 1 - i
+	while(NUM_DIGITS + 1 - i < d){ // If short
 		c_putch(' '); // Fill space
 		d--;
 	}
 	c_puts(&lbuf[i]);
 }
 
+// Return 10 * value + digit c, or negative if it overflows
+num numdigit(num value, char c){
+#if NUM_BITS == 16
+	num tmp;
+
+	tmp = 10 * value + c - '0';
+	if(value > tmp) // It means overflow, as it always was
+		return -1;
+	return tmp;
+#else
+	if(value > (NUM_MAX - (c - '0')) / 10)
+		return -1;
+	return 10 * value + c - '0';
+#endif
+}
+
 // Input numeric and return value
 // Called by only INPUT statement
-short getnum(){
-	short value, tmp;
+num getnum(){
+	num value;
 	char c;
 	unsigned char len;
 	unsigned char sign;
@@ -268,16 +705,23 @@ short getnum(){
 	while((c = c_getch()) != KEY_ENTER){
 		if(((c == 8) || (c == 127)) && (len > 0)){ // Backspace manipulation
 			len--;
-			c_putch(8); c_putch(' '); c_putch(8);
+			if(itty){
+				c_putch(8); c_putch(' '); c_putch(8);
+			}
 		} else
 		if( (len == 0 && (c == '+' || c == '-')) ||
-			(len < 6 && c_isdigit(c))){ // Numeric or sign only
+			(len < NUM_DIGITS + 1 && c_isdigit(c))){ // Numeric or sign only
 			lbuf[len++] = c;
-			c_putch(c);
+			if(itty)
+				c_putch(c); // Echo
 		}
 	}
 	newline();
 	lbuf[len] = 0;
+	if(ieof && len == 0){ // Nothing more to read, not 0
+		err = ERR_EOF;
+		return 0;
+	}
 
 	switch(lbuf[0]){
 	case '-':
@@ -295,38 +739,60 @@ short getnum(){
 	}
 
 	value = 0; // Initialize value
-	tmp = 0; // Temp value
 	while(lbuf[len]){
-		tmp = 10 * value + lbuf[len++] - '0';
-		if(value > tmp){ // It means overflow
+		value = numdigit(value, lbuf[len++]);
+		if(value < 0){ // It means overflow
 			err = ERR_VOF;
 		}
-		value = tmp;
 	}
 	if(sign)
 		return -value;
 	return value;
 }
 
+// Keywords by first character
+// toktoi() tries only the keywords of the first character, in order of
+// kwtbl, so the first match wins as if all were tried(">=" before ">")
+unsigned char kwidx[SIZE_KWTBL]; //i-code sorted by first character
+unsigned char kwtop[257]; //Top of kwidx by first character
+pthread_once_t kwonce = PTHREAD_ONCE_INIT;
+
+// Make kwidx and kwtop, called once
+void kwinit() {
+	unsigned char i, n = 0;
+	short c;
+
+	for (c = 0; c < 256; c++) {
+		kwtop[c] = n;
+		for (i = 0; i < SIZE_KWTBL; i++)
+			if ((unsigned char)kwtbl[i][0] == c)
+				kwidx[n++] = i;
+	}
+	kwtop[256] = n;
+}
+
 // Convert token to i-code
 // Return byte length or 0
-unsigned char toktoi() {
+// s: line to convert, lbuf or a line of LOAD
+unsigned char toktoi(char* s) {
 	unsigned char i; // Loop counter(i-code sometime)
+	unsigned char k; // Index of kwidx
 	unsigned char len = 0; //byte counter
 	char* pkw = 0; // Temporary keyword pointer
 	char* ptok; // Temporary token pointer
-	char* s = lbuf; // Pointer to charactor at line buffer
 	char c; // Surround the string character, " or '
-	short value; //numeric
-	short tmp; //numeric for overflow check
+	num value; //numeric
 
+	pthread_once(&kwonce, kwinit);
 	while (*s) {
 		while (c_isspace(*s)) s++; // Skip space
 
 		//Try keyword conversion
-		for (i = 0; i < SIZE_KWTBL; i++) {
-			pkw = (char *)kwtbl[i]; // Point keyword
-			ptok = s; // Point top of command line
+		i = SIZE_KWTBL; // not found
+		c = c_toupper(*s);
+		for (k = kwtop[(unsigned char)c]; k < kwtop[(unsigned char)c + 1]; k++) {
+			pkw = (char *)kwtbl[kwidx[k]] + 1; // Point keyword
+			ptok = s + 1; // Point top of command line
 
 			// Compare 1 keyword
 			while ((*pkw != 0) && (*pkw == c_toupper(*ptok))) {
@@ -342,6 +808,7 @@ unsigned char toktoi() {
 				}
 
 				// i have i-code
+				i = kwidx[k];
 				ibuf[len++] = i;
 				s = ptok;
 				break;
@@ -351,12 +818,12 @@ unsigned char toktoi() {
 		// Case statement needs an argument except numeric, valiable, or strings
 		if(i == I_REM) {
 			while (c_isspace(*s)) s++; // Skip space
-			ptok = s;
-			for (i = 0; *ptok++; i++); // Get length
-			if (len >= SIZE_IBUF - 2 - i) {
+			for (ptok = s; *ptok; ptok++); // Get length
+			if (len >= SIZE_IBUF - 2 - (ptok - s)) {
 				err = ERR_IBUFOF;
 				return 0;
 			}
+			i = ptok - s;
 			ibuf[len++] = i; // Put length
 			while (i--) { // Copy strings
 				ibuf[len++] = *s++;
@@ -364,7 +831,7 @@ unsigned char toktoi() {
 			break;
 		}
 
-		if (*pkw == 0)
+		if (i < SIZE_KWTBL)
 			continue;
 
 		ptok = s; // Point top of command line
@@ -372,23 +839,29 @@ unsigned char toktoi() {
 		// Try numeric conversion
 		if (c_isdigit(*ptok)) {
 			value = 0;
-			tmp = 0;
 			do {
-				tmp = 10 * value + *ptok++ - '0';
-				if (value > tmp) {
+				value = numdigit(value, *ptok++);
+				if (value < 0) {
 					err = ERR_VOF;
 					return 0;
 				}
-				value = tmp;
+#if NUM_BITS > 16
+				if (len == 0 && value > 32767) {
+					err = ERR_VOF; // line number is 16 bits
+					return 0;
+				}
+#endif
 			} while (c_isdigit(*ptok));
 
-			if (len >= SIZE_IBUF - 3) {
+			if (len >= SIZE_IBUF - 1 - NUM_SIZE) {
 				err = ERR_IBUFOF;
 				return 0;
 			}
 			ibuf[len++] = I_NUM;
-			ibuf[len++] = value & 255;
-			ibuf[len++] = value >> 8;
+			for (i = len == 1 ? 2 : NUM_SIZE; i > 0; i--) { // line number in 2 bytes
+				ibuf[len++] = value & 255;
+				value >>= 8;
+			}
 			s = ptok;
 		}
 		else
@@ -397,12 +870,13 @@ unsigned char toktoi() {
 		if (*s == '\"' || *s == '\'') {// If start of string
 			c = *s++;
 			ptok = s;
-			for (i = 0; (*ptok != c) && c_isprint(*ptok); i++) // Get length
+			while ((*ptok != c) && c_isprint(*ptok)) // Get length
 				ptok++;
-			if (len >= SIZE_IBUF - 1 - i) { // List area full
+			if (len >= SIZE_IBUF - 1 - (ptok - s)) { // List area full
 				err = ERR_IBUFOF;
 				return 0;
 			}
+			i = ptok - s;
 			ibuf[len++] = I_STR; // Put i-code
 			ibuf[len++] = i; // Put length
 			while (i--) { // Put string
@@ -445,65 +919,162 @@ short getlineno(unsigned char *lp) {
 	return *(lp + 1) | *(lp + 2) << 8;
 }
 
-// Search line by line number
-unsigned char* getlp(short lineno) {
+// Get constant of I_NUM at ip
+num getconst(unsigned char* ip) {
+	unum value = 0;
+	unsigned char i;
+
+	for (i = NUM_SIZE; i > 0; i--) // little endian
+		value = value << 8 | *(ip + i);
+	return value;
+}
+
+// Rebuild line index
+// lidx[lcnt] points end of list
+void mkindex() {
 	unsigned char *lp;
 
+	lcnt = 0;
 	for (lp = listbuf; *lp; lp += *lp)
-		if (getlineno(lp) >= lineno)
-			break;
-	return lp;
+		lidx[lcnt++] = lp - listbuf;
+	lidx[lcnt] = lp - listbuf;
+	lend = lp;
+	if (lend - listbuf > ctr.lpeak)
+		ctr.lpeak = lend - listbuf;
+}
+
+// Search line index by line number
+// Return first line that line number >= lineno, or lcnt
+short getli(short lineno) {
+	short lo, hi, mid;
+
+	lo = 0;
+	hi = lcnt;
+	ctr.lookup++;
+	while (lo < hi) { // binary search
+		ctr.scan++;
+		mid = (lo + hi) >> 1;
+		if (getlineno(listbuf + lidx[mid]) < lineno)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+// Search line by line number
+// Return first line that line number >= lineno, or end of list
+unsigned char* getlp(short lineno) {
+	return listbuf + lidx[getli(lineno)];
 }
 
 // Return free memory size
 short getsize() {
-	unsigned char* lp;
+	return listbuf + lsize - lend - 1;
+}
+
+// Skip 1 i-code
+unsigned char* nexti(unsigned char* ip) {
+	switch (*ip) {
+	case I_NUM:
+	case I_LNK:
+		return ip + 1 + NUM_SIZE;
+	case I_VAR:
+		return ip + 2;
+	case I_STR:
+	case I_REM:
+		return ip + 2 + *(ip + 1);
+	default:
+		return ip + 1;
+	}
+}
 
-	for (lp = listbuf; *lp; lp += *lp);
-	return listbuf + SIZE_LIST - lp - 1;
+// Link pass called by RUN
+// Replace constant line number of GOTO/GOSUB with I_LNK and line offset
+void ilink() {
+	unsigned char *lp, *ip, *tp;
+	num lineno;
+
+	for (lp = listbuf; *lp; lp += *lp)
+		for (ip = lp + 3; *ip != I_EOL; ip = nexti(ip)) {
+			if ((*ip != I_GOTO && *ip != I_GOSUB) || *(ip + 1) != I_NUM ||
+				(*(ip + 2 + NUM_SIZE) != I_SEMI && *(ip + 2 + NUM_SIZE) != I_EOL))
+				continue; // not constant jump
+
+			lineno = getconst(ip + 1);
+			tp = getlp(lineno); // search line
+			if (lineno != getlineno(tp)) { // if not found
+				clp = lp;
+				cip = ip;
+				err = ERR_ULN;
+				return;
+			}
+			ip++;
+			*ip = I_LNK;
+			*(ip + 1) = (tp - listbuf) & 255;
+			*(ip + 2) = (tp - listbuf) >> 8;
+			linked = 1;
+		}
+}
+
+// Undo link pass before edit
+void iunlink() {
+	unsigned char *lp, *ip;
+	short lineno;
+
+	for (lp = listbuf; *lp; lp += *lp)
+		for (ip = lp + 3; *ip != I_EOL; ip = nexti(ip)) {
+			if (*ip != I_LNK)
+				continue;
+			lineno = getlineno(listbuf + (*(ip + 1) | *(ip + 2) << 8));
+			*ip = I_NUM;
+			*(ip + 1) = lineno & 255;
+			*(ip + 2) = lineno >> 8;
+		}
+	linked = 0;
 }
 
 // Insert i-code to the list
 // Preconditions to do *ibuf = len
 void inslist() {
 	unsigned char *insp;
-	unsigned char *p1, *p2;
-	short len;
+	short li, len, i;
+
+	if (linked) // offsets will be changed
+		iunlink();
+	eclear();
 
 	if (getsize() < *ibuf) {
 		err = ERR_LBUFOF; // List buffer overflow
 		return;
 	}
 
-	insp = getlp(getlineno(ibuf));
+	li = getli(getlineno(ibuf));
+	insp = listbuf + lidx[li];
 
 	if (getlineno(insp) == getlineno(ibuf)) {// line number agree
-		p1 = insp;
-		p2 = p1 + *p1;
-		while (len = *p2) {
-			while (len--)
-				*p1++ = *p2++;
-		}
-		*p1 = 0;
+		len = *insp;
+		memmove(insp, insp + len, lend - insp - len + 1);
+		lend -= len;
+		for (i = li; i < lcnt; i++) // index after the line
+			lidx[i] = lidx[i + 1] - len;
+		lcnt--;
 	}
 
 	// Case line number only
 	if (*ibuf == 4)
 		return;
 
-	// Make space
-	for (p1 = insp; *p1; p1 += *p1);
-	len = p1 - insp + 1;
-	p2 = p1 + *ibuf;
-	while (len--)
-		*p2-- = *p1--;
-
-	// Insert
+	// Make space and insert
 	len = *ibuf;
-	p1 = insp;
-	p2 = ibuf;
-	while (len--)
-		*p1++ = *p2++;
+	memmove(insp + len, insp, lend - insp + 1);
+	memcpy(insp, ibuf, len);
+	lend += len;
+	if (lend - listbuf > ctr.lpeak)
+		ctr.lpeak = lend - listbuf;
+	for (i = lcnt; i >= li; i--) // index after the line
+		lidx[i + 1] = lidx[i] + len;
+	lcnt++;
 }
 
 //Listing 1 line of i-code
@@ -518,10 +1089,7 @@ void putlist(unsigned char* ip) {
 				c_putch(' ');
 			if (*ip == I_REM) {
 				ip++;
-				i = *ip++;
-				while (i--) {
-					c_putch(*ip++);
-				}
+				c_write((char*)ip + 1, *ip);
 				return;
 			}
 			ip++;
@@ -530,9 +1098,17 @@ void putlist(unsigned char* ip) {
 
 		// Case numeric
 		if (*ip == I_NUM) {
+			putnum(getconst(ip), 0);
+			ip += 1 + NUM_SIZE;
+			if (!nospaceb(*ip)) c_putch(' ');
+		}
+		else
+
+		// Case linked line number
+		if (*ip == I_LNK) {
 			ip++;
-			putnum(*ip | *(ip + 1) << 8, 0);
-			ip += 2;
+			putnum(getlineno(listbuf + (*ip | *(ip + 1) << 8)), 0);
+			ip += NUM_SIZE;
 			if (!nospaceb(*ip)) c_putch(' ');
 		}
 		else
@@ -558,10 +1134,8 @@ void putlist(unsigned char* ip) {
 				}
 
 			c_putch(c);
-			i = *ip++;
-			while (i--) {
-				c_putch(*ip++);
-			}
+			c_write((char*)ip + 1, *ip);
+			ip += *ip + 1;
 			c_putch(c);
 			if (*ip == I_VAR)
 				c_putch(' ');
@@ -576,8 +1150,8 @@ void putlist(unsigned char* ip) {
 }
 
 // Get argument in parenthesis
-short getparam(){
-	short value;
+num getparam(){
+	num value;
 
 	if(*cip != I_OPEN){
 		err = ERR_PAREN;
@@ -597,49 +1171,54 @@ short getparam(){
 }
 
 // Get value
-short ivalue() {
-	short value;
+num ivalue() {
+	num value;
+	ITABLE(tbl, IJUMP(I_NUM), IJUMP(I_PLUS), IJUMP(I_MINUS), IJUMP(I_VAR),
+		IJUMP(I_OPEN), IJUMP(I_ARRAY), IJUMP(I_RND), IJUMP(I_ABS), IJUMP(I_SIZE));
 
+	IDISPATCH(tbl);
 	switch (*cip) {
-	case I_NUM:
-		cip++;
-		value = *cip | *(cip + 1) << 8;
-		cip += 2;
+	ICASE(I_NUM):
+		value = getconst(cip);
+		cip += 1 + NUM_SIZE;
 		break;
-	case I_PLUS:
+	ICASE(I_PLUS):
 		cip++;
 		value = ivalue();
 		break;
-	case I_MINUS:
+	ICASE(I_MINUS):
 		cip++;
 		value = 0 - ivalue();
 		break;
-	case I_VAR:
+	ICASE(I_VAR):
 		cip++;
 		value = var[*cip++];
 		break;
-	case I_OPEN:
+	ICASE(I_OPEN):
 		value = getparam();
 		break;
-	case I_ARRAY:
+	ICASE(I_ARRAY):
 		cip++;
 		value = getparam();
 		if (err)
 			break;
-		if (value >= SIZE_ARRY) {
+		if ((unum)value >= (unum)asize) { // negative too
 			err = ERR_SOR;
 			break;
 		}
 		value = arr[value];
 		break;
-	case I_RND:
+	ICASE(I_RND):
 		cip++;
 		value = getparam();
 		if (err)
 			break;
-		value = getrnd(value);
+		if (rplay) // replay of compiled code, see xreplay()
+			value = rtape[(rtapei - rplay--) & 15];
+		else
+			value = getrnd(value);
 		break;
-	case I_ABS:
+	ICASE(I_ABS):
 		cip++;
 		value = getparam();
 		if (err)
@@ -647,7 +1226,7 @@ short ivalue() {
 		if (value < 0)
 			value *= -1;
 		break;
-	case I_SIZE:
+	ICASE(I_SIZE):
 		cip++;
 		if ((*cip != I_OPEN) || (*(cip + 1) != I_CLOSE)) {
 			err = ERR_PAREN;
@@ -657,7 +1236,7 @@ short ivalue() {
 		value = getsize();
 		break;
 
-	default:
+	IDEFAULT:
 		err = ERR_SYNTAX;
 		break;
 	}
@@ -665,8 +1244,8 @@ short ivalue() {
 }
 
 // multiply or divide calculation
-short imul() {
-	short value, tmp;
+num imul() {
+	num value, tmp;
 
 	value = ivalue();
 	if (err)
@@ -686,7 +1265,7 @@ short imul() {
 				err = ERR_DIVBY0;
 				return -1;
 			}
-			value /= tmp;
+			value = NUM_DIV(value, tmp);
 			break;
 		default:
 			return value;
@@ -694,8 +1273,8 @@ short imul() {
 }
 
 // add or subtract calculation
-short iplus() {
-	short value, tmp;
+num iplus() {
+	num value, tmp;
 
 	value = imul();
 	if (err)
@@ -719,8 +1298,8 @@ short iplus() {
 }
 
 // The parser
-short iexp() {
-	short value, tmp;
+num iexp() {
+	num value, tmp;
 
 	value = iplus();
 	if (err)
@@ -764,70 +1343,519 @@ short iexp() {
 		}
 }
 
-// PRINT handler
-void iprint() {
-	short value;
-	short len;
-	unsigned char i;
+// Expression code
+// The VM and the expression cache compile expressions into stack machine
+// code(words of num, a constant in 1), operations of VM statements are
+// here together
 
-	len = 0;
-	while (*cip != I_SEMI && *cip != I_EOL) {
-		switch (*cip) {
-		case I_STR:
-			cip++;
-			i = *cip++;
-			while (i--)
-				c_putch(*cip++);
-			break;
-		case I_SHARP:
-			cip++;
-			len = iexp();
-			if (err)
-				return;
-			break;
-		default:
-			value = iexp();
-			if (err)
-				return;
-			putnum(value, len);
+// Operation code
+enum{
+	B_NUM, B_VAR, B_ARR, B_RND, B_ABS, B_SIZE,
+	B_NEG, B_ADD, B_SUB, B_MUL, B_DIV, B_SHL, B_SHR,
+	B_EQ, B_NE, B_LT, B_LE, B_GT, B_GE,
+	B_LET, B_CHKA, B_SETA,
+	B_GOTO, B_GOTOX, B_GOSUB, B_GOSUBX, B_RETURN,
+	B_FOR, B_NEXT, B_IF,
+	B_PRINT, B_PSTR, B_PWID, B_PNUM, B_NL,
+	B_REF, B_STOP, B_END
+};
+
+// Operation length(words)
+const unsigned char blen[] = {
+	2, 2, 2, 1, 1, 1,
+	1, 1, 1, 1, 2, 2, 2,
+	1, 1, 1, 1, 1, 1,
+	2, 1, 1,
+	2, 1, 4, 3, 1,
+	4, 2, 2,
+	1, 2, 1, 1, 1,
+	3, 1, 1
+};
+
+TLS num* cp; //Code pointer for compile
+TLS num* cend; //End of code area for compile
+TLS unsigned char cfull; //Code area full
+TLS unsigned char copt; //Compile with optimizer
+TLS unsigned short ofold, oshift, oif; //Optimized count(fold, shift, IF)
+
+// Put 1 word
+void emit(num w) {
+	if (cp < cend)
+		*cp++ = w;
+	else
+		cfull = 1;
+}
+
+// Optimize operation op of left code p to q and right code q to cp
+// Fold constants, drop *1 /1 +0 -0, shift for power of 2 multiplier
+// and divisor, return 1 if done without op
+char bfold(num* p, num* q, short op) {
+	num a, b;
+	short k;
+
+	if (!copt)
+		return 0;
+
+	if (q == p + 2 && *p == B_NUM && cp == q + 2 && *q == B_NUM) {
+		a = *(p + 1);
+		b = *(q + 1);
+		switch (op) { // same as runtime
+		case B_ADD: a += b; break;
+		case B_SUB: a -= b; break;
+		case B_MUL: a *= b; break;
+		case B_DIV:
+			if (b == 0) // runtime error
+				return 0;
+			a = NUM_DIV(a, b);
 			break;
+		case B_EQ: a = (a == b); break;
+		case B_NE: a = (a != b); break;
+		case B_LT: a = (a < b); break;
+		case B_LE: a = (a <= b); break;
+		case B_GT: a = (a > b); break;
+		case B_GE: a = (a >= b); break;
 		}
+		cp = p;
+		emit(B_NUM);
+		emit(a);
+		ofold++;
+		return 1;
+	}
 
-		if (*cip == I_COMMA) {
-			cip++;
-			if (*cip == I_SEMI || *cip == I_EOL)
-				return;
+	if (op != B_ADD && op != B_SUB && op != B_MUL && op != B_DIV)
+		return 0;
+	if (q == p + 2 && *p == B_NUM && (op == B_ADD || op == B_MUL)) {
+		a = *(p + 1); // constant left, swap operands
+		for (k = 0; q + k < cp; k++)
+			p[k] = q[k];
+		cp = p + k;
+		emit(B_NUM);
+		emit(a);
+		q = cp - 2;
+	}
+	if (cp == q + 2 && *q == B_NUM) {
+		b = *(q + 1);
+		if (b == ((op == B_ADD || op == B_SUB) ? 0 : 1)) {
+			cp = q;
+			ofold++;
+			return 1;
 		}
-		else {
-			if (*cip != I_SEMI && *cip != I_EOL) {
-				err = ERR_SYNTAX;
-				return;
+		for (k = 1; k < NUM_BITS - 1; k++)
+			if (b == (num)1 << k && (op == B_MUL || op == B_DIV)) {
+				cp = q;
+				emit(op == B_MUL ? B_SHL : B_SHR);
+				emit(k);
+				oshift++;
+				return 1;
 			}
-		}
 	}
-	newline();
+	return 0;
 }
 
-// INPUT handler
-void iinput() {
-	short value;
-	short index;
-	unsigned char i;
-	unsigned char prompt;
+// Prototypes
+char bexp(unsigned char e);
 
-	while (1) {
-		prompt = 1;
+// Compile argument in parenthesis
+// e: context of runtime error(0, ERR_IFWOC, ERR_LSTKOF, see verrc())
+// Return 0 if not compilable
+char bparam(unsigned char e) {
+	if (*cip != I_OPEN)
+		return 0;
+	cip++;
+	if (!bexp(e))
+		return 0;
+	if (*cip != I_CLOSE)
+		return 0;
+	cip++;
+	return 1;
+}
 
-		if (*cip == I_STR) {
-			cip++;
-			i = *cip++;
-			while (i--)
-				c_putch(*cip++);
-			prompt = 0;
+// Compile value
+char bvalue(unsigned char e) {
+	num* p;
+
+	switch (*cip) {
+	case I_NUM:
+		emit(B_NUM);
+		emit(getconst(cip));
+		cip += 1 + NUM_SIZE;
+		return 1;
+	case I_PLUS:
+		cip++;
+		return bvalue(e);
+	case I_MINUS:
+		cip++;
+		p = cp;
+		if (!bvalue(e))
+			return 0;
+		if (copt && cp == p + 2 && *p == B_NUM) // negative constant
+			*(p + 1) = 0 - *(p + 1);
+		else
+			emit(B_NEG);
+		return 1;
+	case I_VAR:
+		emit(B_VAR);
+		emit(*(cip + 1));
+		cip += 2;
+		return 1;
+	case I_OPEN:
+		return bparam(e);
+	case I_ARRAY:
+		cip++;
+		if (!bparam(e))
+			return 0;
+		emit(B_ARR);
+		emit(e);
+		return 1;
+	case I_RND:
+		cip++;
+		if (!bparam(e))
+			return 0;
+		emit(B_RND);
+		return 1;
+	case I_ABS:
+		cip++;
+		p = cp;
+		if (!bparam(e))
+			return 0;
+		if (copt && cp == p + 2 && *p == B_NUM) {
+			if (*(p + 1) < 0)
+				*(p + 1) *= -1;
+			ofold++;
 		}
+		else
+			emit(B_ABS);
+		return 1;
+	case I_SIZE:
+		if ((*(cip + 1) != I_OPEN) || (*(cip + 2) != I_CLOSE))
+			return 0;
+		cip += 3;
+		emit(B_SIZE);
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// Compile multiply or divide
+char bmul(unsigned char e) {
+	num* p = cp; // left side
+	num* q; // right side
 
+	if (!bvalue(e))
+		return 0;
+
+	while (1)
 		switch (*cip) {
-		case I_VAR:
+		case I_MUL:
+			cip++;
+			q = cp;
+			if (!bvalue(e))
+				return 0;
+			if (!bfold(p, q, B_MUL))
+				emit(B_MUL);
+			break;
+		case I_DIV:
+			cip++;
+			q = cp;
+			if (!bvalue(e))
+				return 0;
+			if (!bfold(p, q, B_DIV)) {
+				emit(B_DIV);
+				emit(e);
+			}
+			break;
+		default:
+			return 1;
+		}
+}
+
+// Compile add or subtract
+char bplus(unsigned char e) {
+	num* p = cp; // left side
+	num* q; // right side
+
+	if (!bmul(e))
+		return 0;
+
+	while (1)
+		switch (*cip) {
+		case I_PLUS:
+			cip++;
+			q = cp;
+			if (!bmul(e))
+				return 0;
+			if (!bfold(p, q, B_ADD))
+				emit(B_ADD);
+			break;
+		case I_MINUS:
+			cip++;
+			q = cp;
+			if (!bmul(e))
+				return 0;
+			if (!bfold(p, q, B_SUB))
+				emit(B_SUB);
+			break;
+		default:
+			return 1;
+		}
+}
+
+// Compile expression
+char bexp(unsigned char e) {
+	unsigned char op;
+	num* p = cp; // left side
+	num* q; // right side
+
+	if (!bplus(e))
+		return 0;
+
+	while (1) {
+		switch (*cip) {
+		case I_EQ: op = B_EQ; break;
+		case I_SHARP: op = B_NE; break;
+		case I_LT: op = B_LT; break;
+		case I_LTE: op = B_LE; break;
+		case I_GT: op = B_GT; break;
+		case I_GTE: op = B_GE; break;
+		default:
+			return 1;
+		}
+		cip++;
+		q = cp;
+		if (!bplus(e))
+			return 0;
+		if (!bfold(p, q, op))
+			emit(op);
+	}
+}
+
+#ifndef NO_ECACHE
+// Expression cache
+// An expression in the list is compiled at the first evaluation, then
+// runs without parsing. After runtime error, iexp() does it once again
+// and reports the error just as before
+#define SIZE_ECODE (lsize < 16384 ? lsize * 2 : 32767) //Expression cache size(words)
+#define ENONE 0xFFFF //Expression not compilable
+
+TLS num* ecode; //Expression cache(end i-code offset, code)
+TLS num* ecp; //Expression cache pointer
+TLS unsigned short* eidx; //Cache offset + 1 of i-code offset(lsize)
+
+// Clear expression cache, called when the list changes
+void eclear() {
+	ecp = ecode;
+	memset(eidx, 0, sizeof(short) * lsize);
+#ifdef PROFILE
+	pclear(); // offsets are changed
+#endif
+}
+
+// Compile expression at i-code offset o
+void ecomp(unsigned short o) {
+	unsigned char* sp = cip;
+
+	cp = ecp + 1;
+	cend = ecode + SIZE_ECODE;
+	cfull = 0;
+	copt = 0;
+	if (!bexp(0))
+		cfull = 1;
+	emit(B_END);
+	if (cfull)
+		eidx[o] = ENONE;
+	else {
+		*ecp = cip - listbuf;
+		eidx[o] = ecp - ecode + 1;
+		ecp = cp;
+	}
+	cip = sp;
+}
+
+// Get value of expression by cache
+num eexp() {
+	num stk[SIZE_IBUF / 2]; // value stack
+	num* sp; // stack pointer(top value)
+	num* pc; // program counter
+	num* q;
+	unsigned short o;
+	ITABLE(tbl, IJUMP(B_NUM), IJUMP(B_VAR), IJUMP(B_ARR), IJUMP(B_RND),
+		IJUMP(B_ABS), IJUMP(B_SIZE), IJUMP(B_NEG), IJUMP(B_ADD), IJUMP(B_SUB),
+		IJUMP(B_MUL), IJUMP(B_DIV), IJUMP(B_SHL), IJUMP(B_SHR), IJUMP(B_EQ),
+		IJUMP(B_NE), IJUMP(B_LT),
+		IJUMP(B_LE), IJUMP(B_GT), IJUMP(B_GE));
+
+	if (err || cip < listbuf || cip >= listbuf + lsize)
+		return iexp(); // direct mode, or error in FOR TO
+	o = cip - listbuf;
+	if (eidx[o] == 0)
+		ecomp(o);
+	if (eidx[o] == ENONE)
+		return iexp();
+
+	pc = ecode + eidx[o];
+	sp = stk;
+	while (1) {
+		VDISPATCH(tbl);
+		switch (*pc++) {
+		ICASE(B_NUM):
+			*++sp = *pc++;
+			VNEXT(tbl);
+		ICASE(B_VAR):
+			*++sp = var[*pc++];
+			VNEXT(tbl);
+		ICASE(B_ARR):
+			if ((unum)*sp >= (unum)asize)
+				goto eerr;
+			pc++;
+			*sp = arr[*sp];
+			VNEXT(tbl);
+		ICASE(B_RND):
+			*sp = rtape[rtapei++ & 15] = getrnd(*sp);
+			VNEXT(tbl);
+		ICASE(B_ABS):
+			if (*sp < 0)
+				*sp *= -1;
+			VNEXT(tbl);
+		ICASE(B_SIZE):
+			*++sp = getsize();
+			VNEXT(tbl);
+		ICASE(B_NEG):
+			*sp = 0 - *sp;
+			VNEXT(tbl);
+		ICASE(B_ADD):
+			sp--;
+			*sp += *(sp + 1);
+			VNEXT(tbl);
+		ICASE(B_SUB):
+			sp--;
+			*sp -= *(sp + 1);
+			VNEXT(tbl);
+		ICASE(B_MUL):
+			sp--;
+			*sp *= *(sp + 1);
+			VNEXT(tbl);
+		ICASE(B_DIV):
+			if (*sp == 0)
+				goto eerr;
+			pc++;
+			sp--;
+			*sp = NUM_DIV(*sp, *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_SHL): // multiply by power of 2
+			*sp = (unum)*sp << *pc++;
+			VNEXT(tbl);
+		ICASE(B_SHR): // divide by power of 2, round to 0
+			*sp = (*sp + (*sp < 0 ? ((num)1 << *pc) - 1 : 0)) >> *pc;
+			pc++;
+			VNEXT(tbl);
+		ICASE(B_EQ):
+			sp--;
+			*sp = (*sp == *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_NE):
+			sp--;
+			*sp = (*sp != *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_LT):
+			sp--;
+			*sp = (*sp < *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_LE):
+			sp--;
+			*sp = (*sp <= *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_GT):
+			sp--;
+			*sp = (*sp > *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_GE):
+			sp--;
+			*sp = (*sp >= *(sp + 1));
+			VNEXT(tbl);
+		IDEFAULT: // B_END
+			cip = listbuf + ecode[eidx[o] - 1];
+			return *sp;
+		}
+	}
+
+eerr: // replay with the same RND values
+	for (q = ecode + eidx[o]; q < pc - 1; q += blen[*q])
+		if (*q == B_RND)
+			rplay++;
+	return iexp();
+}
+#else
+#define eexp iexp
+void eclear() {
+#ifdef PROFILE
+	pclear(); // offsets are changed
+#endif
+}
+#endif
+
+// PRINT handler
+void iprint() {
+	num value;
+	short len;
+
+	len = 0;
+	while (*cip != I_SEMI && *cip != I_EOL) {
+		switch (*cip) {
+		case I_STR:
+			cip++;
+			c_write((char*)cip + 1, *cip);
+			cip += *cip + 1;
+			break;
+		case I_SHARP:
+			cip++;
+			len = eexp();
+			if (err)
+				return;
+			break;
+		default:
+			value = eexp();
+			if (err)
+				return;
+			putnum(value, len);
+			break;
+		}
+
+		if (*cip == I_COMMA) {
+			cip++;
+			if (*cip == I_SEMI || *cip == I_EOL)
+				return;
+		}
+		else {
+			if (*cip != I_SEMI && *cip != I_EOL) {
+				err = ERR_SYNTAX;
+				return;
+			}
+		}
+	}
+	newline();
+}
+
+// INPUT handler
+void iinput() {
+	num value;
+	num index;
+	unsigned char i;
+	unsigned char prompt;
+
+	while (1) {
+		prompt = 1;
+
+		if (*cip == I_STR) {
+			cip++;
+			i = *cip++;
+			while (i--)
+				c_putch(*cip++);
+			prompt = 0;
+		}
+
+		switch (*cip) {
+		case I_VAR:
 			cip++;
 			if (prompt) {
 				c_putch(*cip + 'A');
@@ -843,7 +1871,7 @@ void iinput() {
 			index = getparam();
 			if (err)
 				return;
-			if (index >= SIZE_ARRY) {
+			if ((unum)index >= (unum)asize) {
 				err = ERR_SOR;
 				return;
 			}
@@ -878,7 +1906,7 @@ void iinput() {
 
 // Variable assignment handler
 void ivar() {
-	short value;
+	num value;
 	short index;
 
 	index = *cip++;
@@ -888,7 +1916,7 @@ void ivar() {
 	}
 	cip++;
 
-	value = iexp();
+	value = eexp();
 	if (err)
 		return;
 
@@ -897,14 +1925,14 @@ void ivar() {
 
 // Array assignment handler
 void iarray() {
-	short value;
-	short index;
+	num value;
+	num index;
 
 	index = getparam();
 	if (err)
 		return;
 
-	if (index >= SIZE_ARRY) {
+	if ((unum)index >= (unum)asize) {
 		err = ERR_SOR;
 		return;
 	}
@@ -915,7 +1943,7 @@ void iarray() {
 	}
 	cip++;
 
-	value = iexp();
+	value = eexp();
 	if (err)
 		return;
 
@@ -939,26 +1967,124 @@ void ilet() {
 	}
 }
 
+// JIT handler
+// JIT n: compile a loop to native code at n-th jump back, JIT 0: off
+// (ignored if the build has no JIT)
+void ijit() {
+	num value;
+
+	value = eexp();
+	if (err)
+		return;
+
+	jithot = value < 0 ? 0 : value;
+}
+
+// Optimizer handler
+// OPT 1: optimize the program at RUN, OPT 2: and report, OPT 0: off
+// (ignored if the build has no VM)
+void iopt() {
+	num value;
+
+	value = eexp();
+	if (err)
+		return;
+
+	opt = value < 0 ? 0 : value > 2 ? 2 : value;
+}
+
+// Check keyin and take the checkpoint if requested, the run goes on
+// from ip of line lp. Called when kbflag is set, return 1 if ESC pressed
+char c_kbpoll(unsigned char* lp, unsigned char* ip) {
+	if (c_kbesc())
+		return 1;
+	if (ckreq) {
+		clp = lp;
+		cip = ip;
+		icheck();
+	}
+	return 0;
+}
+
+// Grow FOR stack for 1 more nest
+// Return 0 if the limit
+char lgrow() {
+	lframe* p;
+	unsigned short n;
+
+	if (lstki >= lstkmax)
+		return 0;
+	n = lstkn * 2 < lstkmax ? lstkn * 2 : lstkmax;
+	p = realloc(lstk == lstk0 ? NULL : lstk, sizeof(lframe) * n);
+	if (p == NULL)
+		return 0;
+	if (lstk == lstk0)
+		for (lstkn = 0; lstkn < lstki; lstkn++)
+			p[lstkn] = lstk0[lstkn];
+	lstk = p;
+	lstkn = n;
+	return 1;
+}
+
+// Record statement at cip to trace, line number 0 if direct
+void trec() {
+	if (*cip == I_SEMI || *cip == I_EOL)
+		return;
+	trbuf[trn++ & (SIZE_TRACE - 1)] =
+		(cip >= listbuf && cip < lend ? getlineno(clp) : 0) << 8 | *cip;
+}
+
 // Execute a series of i-code
+// TRON goes through trec() at each statement, threaded code by ttbl
 unsigned char* iexe() {
-	short lineno; //line number
+	num lineno; //line number
 	unsigned char* lp; //temporary line pointer
-	short index, vto, vstep; // FOR-NEXT items
-	short condition; //IF condition
+	short index; // FOR variable
+	num vto, vstep; // FOR-NEXT items
+	lframe* f; // FOR stack frame
+	num condition; //IF condition
+	ITABLE(itbl, IJUMP(I_GOTO), IJUMP(I_GOSUB), IJUMP(I_RETURN),
+		IJUMP(I_FOR), IJUMP(I_NEXT), IJUMP(I_IF), IJUMP(I_REM), IJUMP(I_STOP),
+		IJUMP(I_VAR), IJUMP(I_ARRAY), IJUMP(I_LET), IJUMP(I_PRINT), IJUMP(I_INPUT),
+		IJUMP(I_SEMI), IJUMP(I_JIT), IJUMP(I_OPT), IJUMP(I_LIST), IJUMP(I_NEW),
+		IJUMP(I_RUN), IJUMP(I_LOAD), IJUMP(I_PROFILE),
+		IJUMP(I_STATS), IJUMP(I_TRON), IJUMP(I_TROFF), IJUMP(I_TRACE),
+		IJUMP(I_SAVE), IJUMP(I_CHECKPOINT), IJUMP(I_EOL));
+#ifdef THREADED
+	static const void* const ttbl[256] = { [0 ... 255] = &&L_trace }; // TRON
+	const void* const* tbl = tron ? ttbl : itbl;
+#endif
 
 	while (*cip != I_EOL) {
 
-		if (c_kbhit()) // check keyin
-			if (c_getch() == 27) { // ESC ?
-				err = ERR_ESC;
-				return NULL;
-			}
-
+		if (kbflag && c_kbpoll(clp, cip)) { // time to check keyin
+			err = ERR_ESC;
+			return NULL;
+		}
+#ifndef THREADED
+		if (tron)
+			trec();
+#endif
+#ifdef BENCH
+		if (*cip != I_SEMI)
+			nstmt[*cip]++;
+#endif
+#ifdef PROFILE
+		if (pline && clp != pline) // in RUN and line changed
+			pmark();
+#endif
+
+		IDISPATCH(tbl);
 		switch (*cip) {
 
-		case I_GOTO:
+		ICASE(I_GOTO):
 			cip++;
-			lineno = iexp(); // get line number
+			if (*cip == I_LNK) { // linked by RUN
+				clp = listbuf + (*(cip + 1) | *(cip + 2) << 8);
+				cip = clp + 3;
+				break;
+			}
+			lineno = eexp(); // get line number
 			if (err)
 				break;
 			lp = getlp(lineno); // search line
@@ -969,41 +2095,50 @@ unsigned char* iexe() {
 
 			clp = lp; // update line pointer
 			cip = clp + 3; // update i-code pointer
-			break;
+			SNEXT(tbl);
 
-		case I_GOSUB:
+		ICASE(I_GOSUB):
 			cip++;
-			lineno = iexp(); // get line number
-			if (err)
-				break;
-			lp = getlp(lineno); // search line
-			if (lineno != getlineno(lp)) { // if not found
-				err = ERR_ULN;
-				break;
+			if (*cip == I_LNK) { // linked by RUN
+				lp = listbuf + (*(cip + 1) | *(cip + 2) << 8);
+				cip += 1 + NUM_SIZE;
+			}
+			else {
+				lineno = eexp(); // get line number
+				if (err)
+					break;
+				lp = getlp(lineno); // search line
+				if (lineno != getlineno(lp)) { // if not found
+					err = ERR_ULN;
+					break;
+				}
 			}
 
 			// push pointers
-			if (gstki >= SIZE_GSTK - 2) { // stack overflow ?
+			if (gstki >= gsize - 2) { // stack overflow ?
 				err = ERR_GSTKOF;
 				break;
 			}
+			gstkp[gstki >> 1] = NULL; // no VM resume point
 			gstk[gstki++] = clp; // push line pointer
 			gstk[gstki++] = cip; // push i-code pointer
+			if (gstki > ctr.gmax)
+				ctr.gmax = gstki;
 
 			clp = lp; // update line pointer
 			cip = clp + 3; // update i-code pointer
-			break;
+			SNEXT(tbl);
 
-		case I_RETURN:
+		ICASE(I_RETURN):
 			if (gstki < 2) { // stack empty ?
 				err = ERR_GSTKUF;
 				break;
 			}
 			cip = gstk[--gstki]; // pop line pointer
 			clp = gstk[--gstki]; // pop i-code pointer
-			break;
+			SNEXT(tbl);
 
-		case I_FOR:
+		ICASE(I_FOR):
 			cip++;
 
 			if (*cip++ != I_VAR) { // no variable
@@ -1018,7 +2153,7 @@ unsigned char* iexe() {
 
 			if (*cip == I_TO) {
 				cip++;
-				vto = iexp(); // get TO value
+				vto = eexp(); // get TO value
 			}
 			else {
 				err = ERR_FORWOTO;
@@ -1027,120 +2162,153 @@ unsigned char* iexe() {
 
 			if (*cip == I_STEP) {
 				cip++;
-				vstep = iexp(); // get STEP value
+				vstep = eexp(); // get STEP value
 			}
 			else
 				vstep = 1; // default STEP value
 
 						   // overflow check
-			if (((vstep < 0) && (-32767 - vstep > vto)) ||
-				((vstep > 0) && (32767 - vstep < vto))) {
+			if (((vstep < 0) && (-NUM_MAX - vstep > vto)) ||
+				((vstep > 0) && (NUM_MAX - vstep < vto))) {
 				err = ERR_VOF;
 				break;
 			}
 
-			// push pointers
-			if (lstki >= SIZE_LSTK - 5) { // stack overflow ?
+			// push frame
+			if (lstki >= lstkn && !lgrow()) { // stack overflow ?
 				err = ERR_LSTKOF;
 				break;
 			}
-			lstk[lstki++] = clp; // push line pointer
-			lstk[lstki++] = cip; // push i-code pointer
-								 //Special thanks hardyboy
-			lstk[lstki++] = (unsigned char*)(uintptr_t)vto; // push TO value
-			lstk[lstki++] = (unsigned char*)(uintptr_t)vstep; // push STEP value
-			lstk[lstki++] = (unsigned char*)(uintptr_t)index; // push variable index
-			break;
-
-		case I_NEXT:
-			cip++;
-
-			if (lstki < 5) { // stack empty ?
+			f = lstk + lstki++;
+			if (lstki > ctr.fmax)
+				ctr.fmax = lstki;
+			f->vp = var + index;
+			f->vto = vto;
+			f->vstep = vstep;
+			f->pc = NULL; // no VM loop point
+			f->lp = clp;
+			f->ip = cip;
+			SNEXT(tbl);
+
+		ICASE(I_NEXT):
+			if (lstki == 0) { // stack empty ?
 				err = ERR_LSTKUF;
 				break;
 			}
+			f = lstk + lstki - 1;
+			if (*(cip + 1) == I_VAR && f->vp == var + *(cip + 2)) { // fast path
+				cip += 3;
+				vstep = f->vstep;
+				*f->vp += vstep; // update loop counter
+				if (vstep > 0 ? *f->vp > f->vto : vstep < 0 && *f->vp < f->vto)
+					lstki--; // loop end
+				else {
+					cip = f->ip; // loop continue
+					clp = f->lp;
+				}
+				SNEXT(tbl);
+			}
 
-			index = (short)(uintptr_t)lstk[lstki - 1]; // read variable index
-			if (*cip++ != I_VAR) { // no variable
+			cip++;
+			if (*cip++ != I_VAR) // no variable
 				err = ERR_NEXTWOV;
-				break;
-			}
-			if (*cip++ != index) { // not equal index
+			else // not equal index
 				err = ERR_NEXTUM;
-				break;
-			}
-
-			vstep = (short)(uintptr_t)lstk[lstki - 2]; // read STEP value
-			var[index] += vstep; // update loop counter
-			vto = (short)(uintptr_t)lstk[lstki - 3]; // read TO value
-
-													 // loop end
-			if (((vstep < 0) && (var[index] < vto)) ||
-				((vstep > 0) && (var[index] > vto))) {
-				lstki -= 5; // resume stack
-				break;
-			}
-
-			// loop continue
-			cip = lstk[lstki - 4]; // read line pointer
-			clp = lstk[lstki - 5]; // read i-code pointer
 			break;
 
-		case I_IF:
+		ICASE(I_IF):
 			cip++;
-			condition = iexp(); // get condition
+			condition = eexp(); // get condition
 			if (err) {
 				err = ERR_IFWOC;
 				break;
 			}
-			if (condition) // if true continue
-				break;
+			if (condition) { // if true continue
+				SNEXT(tbl);
+			}
 			// If false, same as REM
 
-		case I_REM:
+		ICASE(I_REM):
 			// Seek pointer to I_EOL
 			// No problem even if it points not realy end of line
 			while (*cip != I_EOL)
 				cip++; // seek end of line
-			break;
+			SNEXT(tbl);
 
-		case I_STOP:
+		ICASE(I_STOP):
 			while (*clp)
 				clp += *clp; // seek end
 			return clp;
 
-		case I_VAR:
+		ICASE(I_VAR):
 			cip++;
 			ivar();
-			break;
-		case I_ARRAY:
+			SNEXT(tbl);
+		ICASE(I_ARRAY):
 			cip++;
 			iarray();
-			break;
-		case I_LET:
+			SNEXT(tbl);
+		ICASE(I_LET):
 			cip++;
 			ilet();
-			break;
-		case I_PRINT:
+			SNEXT(tbl);
+		ICASE(I_PRINT):
 			cip++;
 			iprint();
-			break;
-		case I_INPUT:
+			SNEXT(tbl);
+		ICASE(I_INPUT):
 			cip++;
 			iinput();
-			break;
+			SNEXT(tbl);
 
-		case I_SEMI:
+		ICASE(I_SEMI):
 			cip++;
-			break;
+			SNEXT(tbl);
+
+		ICASE(I_JIT):
+			cip++;
+			ijit();
+			SNEXT(tbl);
 
-		case I_LIST:
-		case I_NEW:
-		case I_RUN:
+		ICASE(I_OPT):
+			cip++;
+			iopt();
+			SNEXT(tbl);
+
+		ICASE(I_TRON):
+		ICASE(I_TROFF):
+			tron = *cip++ == I_TRON;
+#ifdef THREADED
+			tbl = tron ? ttbl : itbl;
+#endif
+			SNEXT(tbl);
+
+		ICASE(I_CHECKPOINT):
+			cip++;
+			icheck(); // resumes after it
+			SNEXT(tbl);
+
+#ifdef THREADED
+		L_trace: // all i-codes by ttbl
+			trec();
+			goto *itbl[*cip];
+#endif
+
+		ICASE(I_LIST):
+		ICASE(I_NEW):
+		ICASE(I_RUN):
+		ICASE(I_LOAD):
+		ICASE(I_PROFILE):
+		ICASE(I_STATS):
+		ICASE(I_TRACE):
+		ICASE(I_SAVE):
 			err = ERR_COM;
 			break;
 
-		default:
+		ICASE(I_EOL): // reached by threaded code only
+			return clp + *clp;
+
+		IDEFAULT:
 			err = ERR_SYNTAX;
 			break;
 		}
@@ -1151,61 +2319,1821 @@ unsigned char* iexe() {
 	return clp + *clp;
 }
 
-// RUN command handler
-void irun() {
-	unsigned char* lp;
+#ifndef NO_VM
+// Bytecode VM
+// RUN compiles the list into stack machine code (words) and runs it.
+// A statement the compiler does not take is left to iexe() by B_REF,
+// iexe() runs it and the rest of the line, then the VM goes on
+#define SIZE_CODE (lsize < 16384 ? lsize * 2 : 32767) //Code area size(words)
+#define SIZE_VSTK 128 //VM value stack size, a line(<256 bytes) never needs more
+
+#if defined(__x86_64__) && !defined(NO_JIT) && NUM_BITS == 16
+#define JIT
+void jreset(void); // Prototype
+#endif
+
+TLS num* code; //Code area
+TLS unsigned short* lpc; //Code offset of line(parallel to lidx)
+TLS unsigned short* xpc; //Code offset of statement expression(lsize / 2)
+TLS unsigned short* xip; //i-code offset of statement expression(lsize / 2)
+TLS short xcnt; //Statement expression count
+
+// Compile expression of statement, keep where it starts for xreplay()
+char btop(unsigned char e) {
+	if (xcnt < lsize / 2) {
+		xpc[xcnt] = cp - code;
+		xip[xcnt++] = cip - listbuf;
+	}
+	else
+		cfull = 1;
+	return bexp(e);
+}
 
-	gstki = 0;
-	lstki = 0;
-	clp = listbuf;
+// Compile PRINT
+char bprint() {
+	emit(B_PRINT);
+	while (*cip != I_SEMI && *cip != I_EOL) {
+		switch (*cip) {
+		case I_STR:
+			emit(B_PSTR);
+			emit(cip + 1 - listbuf);
+			cip += 2 + *(cip + 1);
+			break;
+		case I_SHARP:
+			cip++;
+			if (!btop(0))
+				return 0;
+			emit(B_PWID);
+			break;
+		default:
+			if (!btop(0))
+				return 0;
+			emit(B_PNUM);
+			break;
+		}
 
-	while (*clp) {
-		cip = clp + 3;
-		lp = iexe();
-		if (err)
-			return;
-		clp = lp;
+		if (*cip == I_COMMA) {
+			cip++;
+			if (*cip == I_SEMI || *cip == I_EOL)
+				return 1;
+		}
+		else {
+			if (*cip != I_SEMI && *cip != I_EOL)
+				return 0;
+		}
 	}
+	emit(B_NL);
+	return 1;
 }
 
-// LIST command handler
-void ilist() {
-	short lineno;
-
-	lineno = (*cip == I_NUM) ? getlineno(cip) : 0;
+// Compile 1 statement of line li
+// Return 0 if not compilable, 2 if rest of line is never executed
+char bstmt(short li) {
+	unsigned char index;
+	short lo = lidx[li]; // line offset
+	num* p;
 
-	for (clp = listbuf;
-	*clp && (getlineno(clp) < lineno);
-		clp += *clp);
+	switch (*cip) {
+	case I_GOTO:
+		cip++;
+		if (*cip == I_LNK) { // linked by RUN
+			emit(B_GOTO);
+			emit(getli(getlineno(listbuf + (*(cip + 1) | *(cip + 2) << 8))));
+			return 2;
+		}
+		if (!btop(0))
+			return 0;
+		emit(B_GOTOX);
+		return 2;
 
-		while (*clp) {
-			putnum(getlineno(clp), 0);
-			c_putch(' ');
-			putlist(clp + 3);
-			if (err)
-				break;
-			newline();
-			clp += *clp;
+	case I_GOSUB:
+		cip++;
+		if (*cip == I_LNK) { // linked by RUN
+			emit(B_GOSUB);
+			emit(getli(getlineno(listbuf + (*(cip + 1) | *(cip + 2) << 8))));
+			cip += 1 + NUM_SIZE;
 		}
-}
+		else {
+			if (!btop(0))
+				return 0;
+			emit(B_GOSUBX);
+		}
+		emit(lo);
+		emit(cip - listbuf); // return point
+		return 1;
 
-//NEW command handler
-void inew(void) {
-	unsigned char i;
+	case I_RETURN:
+		emit(B_RETURN);
+		return 2;
+
+	case I_FOR:
+		cip++;
+		if (*cip != I_VAR || *(cip + 2) != I_EQ)
+			return 0;
+		index = *(cip + 1);
+		cip += 3;
+		if (!btop(0))
+			return 0;
+		emit(B_LET);
+		emit(index);
+		if (*cip != I_TO)
+			return 0;
+		cip++;
+		if (!btop(ERR_LSTKOF))
+			return 0;
+		if (*cip == I_STEP) {
+			cip++;
+			if (!btop(ERR_LSTKOF))
+				return 0;
+		}
+		else {
+			emit(B_NUM);
+			emit(1); // default STEP value
+		}
+		emit(B_FOR);
+		emit(index);
+		emit(lo);
+		emit(cip - listbuf); // loop point
+		return 1;
+
+	case I_NEXT:
+		if (*(cip + 1) != I_VAR)
+			return 0;
+		emit(B_NEXT);
+		emit(*(cip + 2));
+		cip += 3;
+		return 1;
+
+	case I_IF:
+		cip++;
+		p = cp;
+		if (!btop(ERR_IFWOC))
+			return 0;
+		if (copt && cp == p + 2 && *p == B_NUM) { // constant condition
+			cp = p;
+			xcnt--;
+			oif++;
+			return *(p + 1) ? 1 : 2; // if false, fall into next line
+		}
+		emit(B_IF);
+		emit(li + 1); // If false, go to next line
+		return 1;
+
+	case I_REM:
+		return 2;
+
+	case I_STOP:
+		emit(B_STOP);
+		return 2;
+
+	case I_LET:
+		cip++;
+		if (*cip != I_VAR && *cip != I_ARRAY)
+			return 0;
+		return bstmt(li);
+
+	case I_VAR:
+		if (*(cip + 2) != I_EQ)
+			return 0;
+		index = *(cip + 1);
+		cip += 3;
+		if (!btop(0))
+			return 0;
+		emit(B_LET);
+		emit(index);
+		return 1;
+
+	case I_ARRAY:
+		cip++;
+		if (*cip != I_OPEN)
+			return 0;
+		cip++;
+		if (!btop(0) || *cip != I_CLOSE)
+			return 0;
+		cip++;
+		emit(B_CHKA);
+		if (*cip != I_EQ)
+			return 0;
+		cip++;
+		if (!btop(0))
+			return 0;
+		emit(B_SETA);
+		return 1;
+
+	case I_PRINT:
+		cip++;
+		return bprint();
+
+	case I_SEMI:
+		cip++;
+		return 1;
+
+	default: // INPUT, or iexe() reports error
+		return 0;
+	}
+}
+
+// Compile 1 line
+void bline(short li) {
+	unsigned char* sp; // statement pointer
+	num* mark;
+	short xmark;
+	unsigned short o[3]; // optimized count at statement
+	char r;
+
+	cip = listbuf + lidx[li] + 3;
+	ofold = oshift = oif = 0;
+	while (*cip != I_EOL) {
+		sp = cip;
+		mark = cp;
+		xmark = xcnt;
+		o[0] = ofold;
+		o[1] = oshift;
+		o[2] = oif;
+		r = bstmt(li);
+		if (r == 0) { // leave it to iexe()
+			cp = mark;
+			xcnt = xmark;
+			ofold = o[0];
+			oshift = o[1];
+			oif = o[2];
+			emit(B_REF);
+			emit(sp - listbuf);
+			emit(lidx[li]);
+			break;
+		}
+		if (r == 2)
+			break;
+	}
+
+	if (opt > 1 && (ofold || oshift || oif)) { // report
+		c_puts("OPT ");
+		putnum(getlineno(listbuf + lidx[li]), 0);
+		c_putch(':');
+		if (ofold) {
+			c_puts(" FOLD ");
+			putnum(ofold, 0);
+		}
+		if (oshift) {
+			c_puts(" SHIFT ");
+			putnum(oshift, 0);
+		}
+		if (oif) {
+			c_puts(" IF ");
+			putnum(oif, 0);
+		}
+		newline();
+	}
+}
+
+// Compile the list
+// Return 0 if code area full
+char vcomp() {
+	short i;
+	num* p;
+
+	cp = code;
+	cend = code + SIZE_CODE;
+	cfull = 0;
+	copt = opt;
+	xcnt = 0;
+	for (i = 0; i < lcnt; i++) {
+		lpc[i] = cp - code;
+		bline(i);
+	}
+	lpc[lcnt] = cp - code;
+	emit(B_END);
+	if (cfull)
+		return 0;
+
+	// Line index to code offset
+	for (p = code; p < cp; p += blen[*p])
+		if (*p == B_GOTO || *p == B_GOSUB || *p == B_IF)
+			*(p + 1) = lpc[*(p + 1)];
+#ifdef JIT
+	jreset();
+#endif
+	return 1;
+}
+
+// Replay statement expression of runtime error at p by iexp()
+// iexp() goes on after error and may report another one, it takes
+// the same RND values as compiled code, return error code
+// e: ERR_LSTKOF replays TO and STEP of FOR, with the overflow check and
+// the stack after error as iexe() does
+unsigned char xreplay(num* p, short e, unsigned char n) {
+	short lo, hi, mid;
+	num* q;
+	num vto, vstep;
+
+	lo = 0;
+	hi = xcnt - 1;
+	while (lo < hi) { // last expression that code offset <= p
+		mid = (lo + hi + 1) >> 1;
+		if (xpc[mid] <= p - code)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	if (e == ERR_LSTKOF && *(listbuf + xip[lo] - 1) == I_STEP)
+		lo--; // from TO
+	rplay = 0;
+	for (q = code + xpc[lo]; q < p; q += blen[*q])
+		if (*q == B_RND)
+			rplay++;
+	cip = listbuf + xip[lo];
+	err = 0;
+	vto = iexp();
+	if (e == ERR_LSTKOF) {
+		if (*cip == I_STEP) {
+			cip++;
+			vstep = iexp();
+		}
+		else
+			vstep = 1;
+		if (((vstep < 0) && (-NUM_MAX - vstep > vto)) ||
+			((vstep > 0) && (NUM_MAX - vstep < vto)))
+			err = ERR_VOF;
+		else if (lstki >= lstkmax)
+			err = ERR_LSTKOF;
+	}
+	rplay = 0;
+	return err ? err : n;
+}
+
+// Return error code of runtime error at operation p
+// e: context(0, ERR_IFWOC in IF, ERR_LSTKOF in FOR TO/STEP), n: error code
+unsigned char verrc(num* p, short e, unsigned char n) {
+	if (e == ERR_IFWOC) // any error in IF
+		return e;
+	return xreplay(p, e, n);
+}
+
+// Set clp and cip to the line of code
+void vline(num* p) {
+	short lo, hi, mid;
+
+	lo = 0;
+	hi = lcnt - 1;
+	while (lo < hi) { // last line that code offset <= p
+		mid = (lo + hi + 1) >> 1;
+		if (lpc[mid] <= p - code)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	clp = listbuf + lidx[lo];
+	cip = clp + 3;
+}
+
+// c_kbpoll() at code p of the start of a line
+char vpoll(num* p) {
+	vline(p);
+	return c_kbpoll(clp, cip);
+}
+
+#ifdef JIT
+// x86-64 JIT, of 16-bit values only
+// A loop the VM jumps back to jithot times is compiled to native code,
+// from the jump destination to the jump. The native loop keeps most used
+// variables in registers and returns the code position the VM goes on
+// with. Anything else(error, ESC, INPUT, GOSUB...) is left to the VM at
+// the operation, with variables and value stack just as the VM has them
+#define SIZE_JIT 65536 //Native code area size(bytes)
+#define SIZE_JFIX 1024 //Jump fixups per loop
+#define JIT_REGS 8 //Variables in registers(r8-r15)
+#define JLAB 255 //Jump fixup to label, not exit
+
+typedef num* (*jitfn)(num**); //Native loop, argument: VM stack pointer
+
+TLS unsigned char* jbuf; //Native code area
+TLS unsigned char* jp; //Native code pointer for compile
+TLS unsigned char jfull; //Native code area or fixups full
+TLS jitfn* jent; //Native loop of code offset
+TLS unsigned short* jcnt; //Jump back count of code offset
+TLS int* jlab; //Native offset of code offset in the loop
+TLS unsigned char jreg[26]; //Register of variable(8-15), or 0 in memory
+TLS int jfat[SIZE_JFIX]; //Fixup position(rel32)
+TLS num* jfpc[SIZE_JFIX]; //Fixup destination
+TLS unsigned char jfd[SIZE_JFIX]; //Fixup stack depth of exit, or JLAB
+TLS short jfn; //Fixup count
+
+// Displacement from var[]
+#define JD(v) (int)((char*)&(v) - (char*)var)
+
+// Forget native code, called by vcomp()
+void jreset() {
+	jp = jbuf;
+	memset(jent, 0, sizeof(jitfn) * SIZE_CODE);
+	memset(jcnt, 0, sizeof(short) * SIZE_CODE);
+}
+
+// Put n bytes
+void jb(int n, ...) {
+	va_list ap;
+
+	va_start(ap, n);
+	while (n--)
+		*jp++ = va_arg(ap, int);
+	va_end(ap);
+}
+
+// Put 32 bits
+void jd(int v) {
+	jb(4, v, v >> 8, v >> 16, v >> 24);
+}
+
+// Put 64 bits
+void jq(uintptr_t v) {
+	jd(v);
+	jd(v >> 32);
+}
+
+// Put jump to code position p(cc: 0x8x jcc or 0 jmp)
+// d: stack depth to exit to the VM there, or JLAB to native label
+void jjmp(unsigned char cc, num* p, unsigned char d) {
+	if (cc)
+		jb(2, 0x0F, cc);
+	else
+		jb(1, 0xE9);
+	if (jfn < SIZE_JFIX) {
+		jfat[jfn] = jp - jbuf;
+		jfpc[jfn] = p;
+		jfd[jfn++] = d;
+	}
+	else
+		jfull = 1;
+	jd(0);
+}
+
+// Put exit to code position p, stack depth d
+// Pass values of stack(ax, then pushed) to the VM
+void jexit(num* p, unsigned char d, unsigned char* epi) {
+	short k;
+
+	if (d)
+		jb(3, 0x66, 0x89, 0x86), jd(d * 2); // mov [rsi+2d],ax
+	for (k = d - 1; k >= 1; k--) {
+		jb(1, 0x59); // pop rcx
+		jb(3, 0x66, 0x89, 0x8E), jd(k * 2); // mov [rsi+2k],cx
+	}
+	jb(3, 0x48, 0x8D, 0x8E), jd(d * 2); // lea rcx,[rsi+2d]
+	jb(3, 0x48, 0x89, 0x0F); // mov [rdi],rcx
+	jb(2, 0x48, 0xB8), jq((uintptr_t)p); // mov rax,p
+	jb(1, 0xE9), jd(epi - (jp + 4)); // jmp epilogue
+}
+
+// Put overflow check of FOR, exit at p if TO and STEP make overflow
+void jforchk(num* p) {
+	jb(4, 0x48, 0x8B, 0x0C, 0x24); // mov rcx,[rsp] (TO)
+	jb(3, 0x0F, 0xBF, 0xD0); // movsx edx,ax (STEP)
+	jb(3, 0x0F, 0xBF, 0xC9); // movsx ecx,cx
+	jb(3, 0x66, 0x85, 0xC0); // test ax,ax
+	jb(2, 0x74, 31); // jz ok
+	jb(3, 0x8D, 0x14, 0x0A); // lea edx,[rdx+rcx]
+	jb(2, 0x78, 14); // js neg
+	jb(2, 0x81, 0xFA), jd(32767); // cmp edx,32767
+	jjmp(0x8F, p, 2); // jg exit
+	jb(2, 0xEB, 12); // jmp ok
+	jb(2, 0x81, 0xFA), jd(-32767); // neg: cmp edx,-32767
+	jjmp(0x8C, p, 2); // jl exit
+}
+
+// Return 1 if native code has the operation
+char jok(short op) {
+	switch (op) {
+	case B_RND: case B_GOTOX: case B_GOSUB: case B_GOSUBX: case B_RETURN:
+	case B_PRINT: case B_PSTR: case B_PWID: case B_PNUM: case B_NL:
+	case B_REF: case B_STOP: case B_END:
+		return 0;
+	default:
+		return 1;
+	}
+}
+
+// Compile loop from head to end(after jump back)
+// Return native entry, or NULL if not compiled
+jitfn jcomp(num* head, num* end) {
+	unsigned char* entry;
+	unsigned char* epi; // epilogue
+	num* p;
+	num* jfor[26]; // loop point of FOR in the loop
+	short n[26]; // use count of variable
+	unsigned char d; // stack depth
+	unsigned char r;
+	short i, j;
+	int at, to; // fixup position, destination
+
+	if (jbuf == NULL) {
+		jbuf = mmap(NULL, SIZE_JIT, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (jbuf == MAP_FAILED) {
+			jbuf = NULL;
+			return NULL;
+		}
+		jp = jbuf;
+	}
+	if (!jok(*head))
+		return NULL;
+	mprotect(jbuf, SIZE_JIT, PROT_READ | PROT_WRITE);
+
+	// Most used variables to registers
+	for (i = 0; i < 26; i++) {
+		n[i] = 0;
+		jreg[i] = 0;
+		jfor[i] = NULL;
+	}
+	for (p = head; p < end; p += blen[*p])
+		if (*p == B_VAR || *p == B_LET || *p == B_FOR || *p == B_NEXT)
+			n[*(p + 1)]++;
+	for (r = 8; r < 8 + JIT_REGS; r++) {
+		for (j = 0, i = 1; i < 26; i++)
+			if (n[i] > n[j])
+				j = i;
+		if (n[j] == 0)
+			break;
+		jreg[j] = r;
+		n[j] = 0;
+	}
+
+	// Prologue
+	entry = jp;
+	jfull = 0;
+	jfn = 0;
+	jb(6, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41); // push rbx,r12,r13
+	jb(3, 0x56, 0x41, 0x57); // push r14,r15
+	jb(2, 0x48, 0xBB), jq((uintptr_t)var); // mov rbx,var
+	jb(3, 0x48, 0x8B, 0x37); // mov rsi,[rdi] (VM stack)
+	for (i = 0; i < 26; i++)
+		if (jreg[i]) // movzx r,word [rbx+var]
+			jb(4, 0x44, 0x0F, 0xB7, 0x83 | (jreg[i] & 7) << 3), jd(i * 2);
+
+	// Loop body
+	// Stack top is in ax, others pushed
+	d = 0;
+	for (p = head; p < end; p += blen[*p]) {
+		if (jp > jbuf + SIZE_JIT - 256) {
+			jfull = 1;
+			break;
+		}
+		jlab[p - code] = jp - jbuf;
+		switch (*p) {
+		case B_NUM:
+			if (d++)
+				jb(1, 0x50); // push rax
+			jb(1, 0xB8), jd((unsigned short)*(p + 1)); // mov eax,n
+			break;
+		case B_VAR:
+			if (d++)
+				jb(1, 0x50); // push rax
+			r = jreg[*(p + 1)];
+			if (r) // mov eax,r
+				jb(3, 0x44, 0x89, 0xC0 | (r & 7) << 3);
+			else // movzx eax,word [rbx+var]
+				jb(3, 0x0F, 0xB7, 0x83), jd(*(p + 1) * 2);
+			break;
+		case B_SIZE:
+			if (d++)
+				jb(1, 0x50); // push rax
+			jb(1, 0xB8), jd((unsigned short)getsize()); // list never changes in RUN
+			break;
+		case B_ARR:
+		case B_CHKA:
+			jb(3, 0x0F, 0xB7, 0xC8); // movzx ecx,ax
+			jb(2, 0x81, 0xF9), jd(asize); // cmp ecx,asize
+			jjmp(0x83, p, d); // jae exit
+			if (*p == B_ARR) { // movzx eax,word [arr+rcx*2]
+				jb(2, 0x48, 0xBA), jq((uintptr_t)arr); // mov rdx,arr
+				jb(4, 0x0F, 0xB7, 0x04, 0x4A);
+			}
+			break;
+		case B_ABS:
+			jb(3, 0x66, 0x85, 0xC0); // test ax,ax
+			jb(2, 0x79, 3); // jns +3
+			jb(3, 0x66, 0xF7, 0xD8); // neg ax
+			break;
+		case B_NEG:
+			jb(3, 0x66, 0xF7, 0xD8); // neg ax
+			break;
+		case B_ADD:
+			jb(3, 0x59, 0x01, 0xC8); // pop rcx; add eax,ecx
+			d--;
+			break;
+		case B_SUB:
+			jb(5, 0x59, 0x29, 0xC1, 0x89, 0xC8); // pop rcx; sub ecx,eax; mov eax,ecx
+			d--;
+			break;
+		case B_MUL:
+			jb(4, 0x59, 0x0F, 0xAF, 0xC1); // pop rcx; imul eax,ecx
+			d--;
+			break;
+		case B_DIV: // in 32 bits, -32768/-1 is 32768 as iexe()
+			jb(3, 0x66, 0x85, 0xC0); // test ax,ax
+			jjmp(0x84, p, d); // jz exit
+			jb(3, 0x0F, 0xBF, 0xC8); // movsx ecx,ax
+			jb(4, 0x58, 0x0F, 0xBF, 0xC0); // pop rax; movsx eax,ax
+			jb(3, 0x99, 0xF7, 0xF9); // cdq; idiv ecx
+			d--;
+			break;
+		case B_SHL:
+			jb(3, 0xC1, 0xE0, *(p + 1)); // shl eax,k
+			break;
+		case B_SHR:
+			jb(3, 0x0F, 0xBF, 0xC0); // movsx eax,ax
+			jb(5, 0x89, 0xC1, 0xC1, 0xF9, 0x1F); // mov ecx,eax; sar ecx,31
+			jb(6, 0x81, 0xE1, (1 << *(p + 1)) - 1, ((1 << *(p + 1)) - 1) >> 8, 0, 0); // and ecx,2^k-1
+			jb(2, 0x01, 0xC8); // add eax,ecx
+			jb(3, 0xC1, 0xF8, *(p + 1)); // sar eax,k
+			break;
+		case B_EQ: case B_NE: case B_LT: case B_LE: case B_GT: case B_GE:
+			jb(4, 0x59, 0x66, 0x39, 0xC1); // pop rcx; cmp cx,ax
+			jb(3, 0x0F, // setcc al
+				*p == B_EQ ? 0x94 : *p == B_NE ? 0x95 : *p == B_LT ? 0x9C :
+				*p == B_LE ? 0x9E : *p == B_GT ? 0x9F : 0x9D, 0xC0);
+			jb(3, 0x0F, 0xB6, 0xC0); // movzx eax,al
+			d--;
+			break;
+		case B_LET:
+			r = jreg[*(p + 1)];
+			if (r) // mov r,eax
+				jb(3, 0x41, 0x89, 0xC0 | (r & 7));
+			else // mov [rbx+var],ax
+				jb(3, 0x66, 0x89, 0x83), jd(*(p + 1) * 2);
+			d--;
+			break;
+		case B_SETA:
+			jb(4, 0x59, 0x0F, 0xB7, 0xC9); // pop rcx; movzx ecx,cx
+			jb(2, 0x48, 0xBA), jq((uintptr_t)arr); // mov rdx,arr
+			jb(4, 0x66, 0x89, 0x04, 0x4A); // mov [arr+rcx*2],ax
+			d -= 2;
+			break;
+		case B_GOTO:
+			jb(2, 0x83, 0xBB), jd(JD(kbflag)), jb(1, 0); // cmp dword [kbflag],0
+			jjmp(0x85, p, 0); // jne exit, the VM checks ESC
+			if (code + *(p + 1) >= head && code + *(p + 1) < end)
+				jjmp(0, code + *(p + 1), JLAB);
+			else
+				jjmp(0, code + *(p + 1), 0);
+			break;
+		case B_IF:
+			jb(3, 0x66, 0x85, 0xC0); // test ax,ax
+			d--;
+			if (code + *(p + 1) < end) // jz next line
+				jjmp(0x84, code + *(p + 1), JLAB);
+			else
+				jjmp(0x84, code + *(p + 1), 0);
+			break;
+		case B_FOR:
+			jforchk(p);
+			jb(3, 0x0F, 0xB7, 0x93), jd(JD(lstki)); // movzx edx,word [lstki]
+			jb(3, 0x0F, 0xB7, 0x8B), jd(JD(lstkn)); // movzx ecx,word [lstkn]
+			jb(2, 0x39, 0xCA); // cmp edx,ecx
+			jjmp(0x83, p, 2); // jae exit, the VM grows stack
+			jb(3, 0x6B, 0xD2, sizeof(lframe)); // imul edx,edx,sizeof(lframe)
+			jb(3, 0x48, 0x03, 0x93), jd(JD(lstk)); // add rdx,[lstk]
+			jb(5, 0x59, 0x66, 0x89, 0x4A, offsetof(lframe, vto)); // pop rcx; TO
+			jb(4, 0x66, 0x89, 0x42, offsetof(lframe, vstep)); // STEP
+			jb(2, 0x48, 0xB9), jq((uintptr_t)(var + *(p + 1))); // mov rcx,counter
+			jb(4, 0x48, 0x89, 0x4A, offsetof(lframe, vp));
+			jb(2, 0x48, 0xB9), jq((uintptr_t)(p + 4)); // mov rcx,loop point
+			jb(4, 0x48, 0x89, 0x4A, offsetof(lframe, pc));
+			jb(2, 0x48, 0xB9), jq((uintptr_t)(listbuf + *(p + 2))); // mov rcx,line
+			jb(4, 0x48, 0x89, 0x4A, offsetof(lframe, lp));
+			jb(2, 0x48, 0xB9), jq((uintptr_t)(listbuf + *(p + 3))); // mov rcx,i-code
+			jb(4, 0x48, 0x89, 0x4A, offsetof(lframe, ip));
+			jb(3, 0x66, 0xFF, 0x83), jd(JD(lstki)); // inc word [lstki]
+			jb(3, 0x0F, 0xB7, 0x93), jd(JD(lstki)); // movzx edx,word [lstki]
+			jb(3, 0x66, 0x3B, 0x93), jd(JD(ctr.fmax)); // cmp dx,[fmax]
+			jb(2, 0x76, 7); // jbe +7
+			jb(3, 0x66, 0x89, 0x93), jd(JD(ctr.fmax)); // mov [fmax],dx
+			jfor[*(p + 1)] = p + 4;
+			d = 0;
+			break;
+		case B_NEXT:
+			i = *(p + 1);
+			r = jreg[i];
+			jb(2, 0x83, 0xBB), jd(JD(kbflag)), jb(1, 0); // cmp dword [kbflag],0
+			jjmp(0x85, p, 0); // jne exit, the VM checks ESC
+			jb(3, 0x0F, 0xB7, 0x93), jd(JD(lstki)); // movzx edx,word [lstki]
+			jb(2, 0x85, 0xD2); // test edx,edx
+			jjmp(0x84, p, 0); // jz exit
+			jb(3, 0x6B, 0xD2, sizeof(lframe)); // imul edx,edx,sizeof(lframe)
+			jb(3, 0x48, 0x03, 0x93), jd(JD(lstk)); // add rdx,[lstk] (end of frame)
+			jb(2, 0x48, 0xB9), jq((uintptr_t)(var + i)); // mov rcx,counter
+			jb(4, 0x48, 0x39, 0x4A, offsetof(lframe, vp) - sizeof(lframe)); // cmp
+			jjmp(0x85, p, 0); // jne exit
+			jb(2, 0x48, 0xB9), jq((uintptr_t)(jfor[i] ? jfor[i] : head)); // mov rcx,loop point
+			jb(4, 0x48, 0x39, 0x4A, offsetof(lframe, pc) - sizeof(lframe)); // cmp
+			jjmp(0x85, p, 0); // jne exit, not this loop
+			jb(4, 0x0F, 0xBF, 0x4A, offsetof(lframe, vstep) - sizeof(lframe)); // movsx ecx,STEP
+			if (r) {
+				jb(3, 0x41, 0x01, 0xC8 | (r & 7)); // add r,ecx
+				jb(4, 0x41, 0x0F, 0xBF, 0xC0 | (r & 7)); // movsx eax,r
+			}
+			else {
+				jb(3, 0x66, 0x01, 0x8B), jd(i * 2); // add [rbx+var],cx
+				jb(3, 0x0F, 0xBF, 0x83), jd(i * 2); // movsx eax,word [rbx+var]
+			}
+			jb(4, 0x0F, 0xBF, 0x52, offsetof(lframe, vto) - sizeof(lframe)); // movsx edx,TO
+			jb(2, 0x85, 0xC9); // test ecx,ecx
+			jb(2, 0x74, 12); // jz cont
+			jb(2, 0x78, 6); // js neg
+			jb(4, 0x39, 0xD0, 0x7F, 11); // cmp eax,edx; jg end
+			jb(2, 0xEB, 4); // jmp cont
+			jb(4, 0x39, 0xD0, 0x7C, 5); // neg: cmp eax,edx; jl end
+			jjmp(0, jfor[i] ? jfor[i] : head, JLAB); // cont: loop
+			jb(3, 0x66, 0xFF, 0x8B), jd(JD(lstki)); // end: dec word [lstki]
+			break;
+		default: // left to the VM
+			jjmp(0, p, d);
+			if (*p == B_GOTOX || *p == B_GOSUBX || *p == B_PWID || *p == B_PNUM)
+				d--;
+			break;
+		}
+	}
+	jjmp(0, end, 0); // loop end
+
+	// Epilogue
+	epi = jp;
+	for (i = 25; i >= 0; i--)
+		if (jreg[i]) // mov [rbx+var],r
+			jb(4, 0x66, 0x44, 0x89, 0x83 | (jreg[i] & 7) << 3), jd(i * 2);
+	jb(6, 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D); // pop r15,r14,r13
+	jb(4, 0x41, 0x5C, 0x5B, 0xC3); // pop r12,rbx; ret
+
+	// Exits and jumps
+	for (i = 0; i < jfn && !jfull; i++) {
+		if (jfd[i] == JLAB)
+			to = jlab[jfpc[i] - code];
+		else {
+			if (jp > jbuf + SIZE_JIT - 64 - jfd[i] * 10) {
+				jfull = 1;
+				break;
+			}
+			to = jp - jbuf;
+			jexit(jfpc[i], jfd[i], epi);
+		}
+		at = jfat[i];
+		*(int*)(jbuf + at) = to - (at + 4);
+	}
+	mprotect(jbuf, SIZE_JIT, PROT_READ | PROT_EXEC);
+
+	if (jfull) {
+		jp = entry;
+		return NULL;
+	}
+	return (jitfn)entry;
+}
+#endif
+
+// Run the code, or the rest of the line by iexe() from cip if resume
+// Return line to go on by iexe() after TRON, or NULL
+unsigned char* vrun(char resume) {
+	num* pc; // program counter
+	num* dst; // GOSUB destination
+#ifdef JIT
+	num* jend; // end of loop to JIT
+#endif
+	num stk[SIZE_VSTK]; // value stack
+	num* sp; // stack pointer(top value)
+	short width; // PRINT width
+	num lineno, vto, vstep;
+	short i;
+	lframe* f; // FOR stack frame
+	unsigned char* lp;
+	ITABLE(tbl, IJUMP(B_NUM), IJUMP(B_VAR), IJUMP(B_ARR), IJUMP(B_RND),
+		IJUMP(B_ABS), IJUMP(B_SIZE), IJUMP(B_NEG), IJUMP(B_ADD), IJUMP(B_SUB),
+		IJUMP(B_MUL), IJUMP(B_DIV), IJUMP(B_SHL), IJUMP(B_SHR), IJUMP(B_EQ),
+		IJUMP(B_NE), IJUMP(B_LT),
+		IJUMP(B_LE), IJUMP(B_GT), IJUMP(B_GE), IJUMP(B_LET), IJUMP(B_CHKA),
+		IJUMP(B_SETA), IJUMP(B_GOTO), IJUMP(B_GOTOX), IJUMP(B_GOSUB),
+		IJUMP(B_GOSUBX), IJUMP(B_RETURN), IJUMP(B_FOR), IJUMP(B_NEXT),
+		IJUMP(B_IF), IJUMP(B_PRINT), IJUMP(B_PSTR), IJUMP(B_PWID),
+		IJUMP(B_PNUM), IJUMP(B_NL), IJUMP(B_REF), IJUMP(B_STOP), IJUMP(B_END));
+
+	pc = code;
+	sp = stk;
+	width = 0;
+	if (resume) // at cip of clp
+		goto vref;
+	while (1) {
+		VDISPATCH(tbl);
+		switch (*pc++) {
+		ICASE(B_NUM):
+			*++sp = *pc++;
+			VNEXT(tbl);
+		ICASE(B_VAR):
+			*++sp = var[*pc++];
+			VNEXT(tbl);
+		ICASE(B_ARR):
+			if ((unum)*sp >= (unum)asize) {
+				err = verrc(pc - 1, *pc, ERR_SOR);
+				goto verr;
+			}
+			pc++;
+			*sp = arr[*sp];
+			VNEXT(tbl);
+		ICASE(B_RND):
+			*sp = rtape[rtapei++ & 15] = getrnd(*sp);
+			VNEXT(tbl);
+		ICASE(B_ABS):
+			if (*sp < 0)
+				*sp *= -1;
+			VNEXT(tbl);
+		ICASE(B_SIZE):
+			*++sp = getsize();
+			VNEXT(tbl);
+
+		ICASE(B_NEG):
+			*sp = 0 - *sp;
+			VNEXT(tbl);
+		ICASE(B_ADD):
+			sp--;
+			*sp += *(sp + 1);
+			VNEXT(tbl);
+		ICASE(B_SUB):
+			sp--;
+			*sp -= *(sp + 1);
+			VNEXT(tbl);
+		ICASE(B_MUL):
+			sp--;
+			*sp *= *(sp + 1);
+			VNEXT(tbl);
+		ICASE(B_DIV):
+			if (*sp == 0) {
+				err = verrc(pc - 1, *pc, ERR_DIVBY0);
+				goto verr;
+			}
+			pc++;
+			sp--;
+			*sp = NUM_DIV(*sp, *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_SHL): // multiply by power of 2
+			*sp = (unum)*sp << *pc++;
+			VNEXT(tbl);
+		ICASE(B_SHR): // divide by power of 2, round to 0
+			*sp = (*sp + (*sp < 0 ? ((num)1 << *pc) - 1 : 0)) >> *pc;
+			pc++;
+			VNEXT(tbl);
+
+		ICASE(B_EQ):
+			sp--;
+			*sp = (*sp == *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_NE):
+			sp--;
+			*sp = (*sp != *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_LT):
+			sp--;
+			*sp = (*sp < *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_LE):
+			sp--;
+			*sp = (*sp <= *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_GT):
+			sp--;
+			*sp = (*sp > *(sp + 1));
+			VNEXT(tbl);
+		ICASE(B_GE):
+			sp--;
+			*sp = (*sp >= *(sp + 1));
+			VNEXT(tbl);
+
+		ICASE(B_LET):
+			var[*pc++] = *sp--;
+			VNEXT(tbl);
+		ICASE(B_CHKA): // check array index before right side
+			if ((unum)*sp >= (unum)asize) {
+				err = ERR_SOR;
+				goto verr;
+			}
+			VNEXT(tbl);
+		ICASE(B_SETA):
+			arr[*(sp - 1)] = *sp;
+			sp -= 2;
+			VNEXT(tbl);
+
+		ICASE(B_GOTO):
+#ifdef JIT
+			jend = pc + 1;
+#endif
+			pc = code + *pc;
+			if (kbflag && vpoll(pc))
+				goto vesc;
+#ifdef JIT
+			if (jithot)
+				goto vjit;
+#endif
+			VNEXT(tbl);
+		ICASE(B_GOTOX):
+			lineno = *sp--;
+			i = getli(lineno); // search line
+			if (lineno != getlineno(listbuf + lidx[i])) { // if not found
+				err = ERR_ULN;
+				goto verr;
+			}
+			pc = code + lpc[i];
+			if (kbflag && vpoll(pc))
+				goto vesc;
+			VNEXT(tbl);
+
+		ICASE(B_GOSUBX):
+			lineno = *sp--;
+			i = getli(lineno); // search line
+			if (lineno != getlineno(listbuf + lidx[i])) { // if not found
+				err = ERR_ULN;
+				goto verr;
+			}
+			dst = code + lpc[i];
+			goto vgosub;
+		ICASE(B_GOSUB):
+			dst = code + *pc++;
+		vgosub:
+			if (gstki >= gsize - 2) { // stack overflow ?
+				err = ERR_GSTKOF;
+				goto verr;
+			}
+			gstkp[gstki >> 1] = pc + 2; // push resume point
+			gstk[gstki++] = listbuf + *pc; // push line pointer
+			gstk[gstki++] = listbuf + *(pc + 1); // push i-code pointer
+			if (gstki > ctr.gmax)
+				ctr.gmax = gstki;
+			pc = dst;
+			if (kbflag && vpoll(pc))
+				goto vesc;
+			VNEXT(tbl);
+
+		ICASE(B_RETURN):
+			if (gstki < 2) { // stack empty ?
+				err = ERR_GSTKUF;
+				goto verr;
+			}
+			gstki -= 2;
+			pc = gstkp[gstki >> 1];
+			if (pc == NULL) { // pushed by iexe()
+				cip = gstk[gstki + 1];
+				clp = gstk[gstki];
+				goto vref;
+			}
+			if (kbflag && c_kbpoll(gstk[gstki], gstk[gstki + 1]))
+				goto vesc;
+			VNEXT(tbl);
+
+		ICASE(B_FOR):
+			vstep = *sp--;
+			vto = *sp--;
+			// overflow check
+			if (((vstep < 0) && (-NUM_MAX - vstep > vto)) ||
+				((vstep > 0) && (NUM_MAX - vstep < vto))) {
+				err = ERR_VOF;
+				goto verr;
+			}
+			if (lstki >= lstkn && !lgrow()) { // stack overflow ?
+				err = ERR_LSTKOF;
+				goto verr;
+			}
+			f = lstk + lstki++;
+			if (lstki > ctr.fmax)
+				ctr.fmax = lstki;
+			f->vp = var + *pc;
+			f->vto = vto;
+			f->vstep = vstep;
+			f->pc = pc + 3; // loop point
+			f->lp = listbuf + *(pc + 1);
+			f->ip = listbuf + *(pc + 2);
+			pc += 3;
+			VNEXT(tbl);
+
+		ICASE(B_NEXT):
+			if (lstki == 0) { // stack empty ?
+				err = ERR_LSTKUF;
+				goto verr;
+			}
+			f = lstk + lstki - 1;
+			if (f->vp != var + *pc++) { // not equal index
+				err = ERR_NEXTUM;
+				goto verr;
+			}
+			vstep = f->vstep;
+			*f->vp += vstep; // update loop counter
+			if (vstep > 0 ? *f->vp > f->vto : vstep < 0 && *f->vp < f->vto) {
+				lstki--; // loop end
+				VNEXT(tbl);
+			}
+
+			// loop continue
+#ifdef JIT
+			jend = pc;
+#endif
+			pc = f->pc;
+			if (pc == NULL) { // pushed by iexe()
+				cip = f->ip;
+				clp = f->lp;
+				goto vref;
+			}
+			if (kbflag && c_kbpoll(f->lp, f->ip))
+				goto vesc;
+#ifdef JIT
+			if (jithot)
+				goto vjit;
+#endif
+			VNEXT(tbl);
+
+		ICASE(B_IF):
+			if (*sp--)
+				pc++;
+			else
+				pc = code + *pc; // next line
+			VNEXT(tbl);
+
+		ICASE(B_PRINT):
+			width = 0;
+			VNEXT(tbl);
+		ICASE(B_PSTR):
+			lp = listbuf + *pc++;
+			c_write((char*)lp + 1, *lp);
+			VNEXT(tbl);
+		ICASE(B_PWID):
+			width = *sp--;
+			VNEXT(tbl);
+		ICASE(B_PNUM):
+			putnum(*sp--, width);
+			VNEXT(tbl);
+		ICASE(B_NL):
+			newline();
+			VNEXT(tbl);
+
+		ICASE(B_REF): // run by iexe()
+			cip = listbuf + *pc;
+			clp = listbuf + *(pc + 1);
+		vref:
+			lp = iexe();
+			if (err || !*lp)
+				return NULL;
+			if (tron) // TRON, the rest runs on iexe()
+				return lp;
+			pc = code + lpc[getli(getlineno(lp))];
+			VNEXT(tbl);
+
+#ifdef JIT
+		vjit: // jumped back from jend to pc
+			i = pc - code;
+			if (jent[i] == NULL) {
+				if (pc >= jend || jcnt[i] >= jithot || ++jcnt[i] < jithot)
+					VNEXT(tbl);
+				jent[i] = jcomp(pc, jend);
+				if (jent[i] == NULL)
+					VNEXT(tbl);
+			}
+			pc = jent[i](&sp);
+			VNEXT(tbl);
+#endif
+
+		ICASE(B_STOP):
+		ICASE(B_END):
+		IDEFAULT:
+			clp = lend; // end of list as iexe()
+			return NULL;
+		}
+	}
+
+verr:
+	vline(pc - 1);
+	return NULL;
+
+vesc:
+	err = ERR_ESC;
+	vline(pc);
+	return NULL;
+}
+#endif
+
+// RUN command handler
+void irun() {
+	ilink(); // resolve constant GOTO/GOSUB
+	if (err)
+		return;
+
+	gstki = 0;
+	lstki = 0;
+	clp = listbuf;
+	cip = clp + 3;
+	igo(0);
+}
+
+// Run from cip of clp with the stacks as they are
+// resume: 0 from the start(RUN), 1 from a checkpoint
+void igo(char resume) {
+	unsigned char* lp;
+#ifndef NO_VM
+	unsigned char* ip;
+
+	lp = clp;
+	ip = cip;
+	if (!tron && vcomp()) { // compile(moves clp, cip), TRON needs iexe()
+		clp = lp;
+		cip = ip;
+		lp = vrun(resume); // line to go on after TRON
+		if (lp == NULL)
+			return;
+		ip = lp + 3;
+	}
+	clp = lp;
+	cip = ip;
+#else
+	(void)resume; // iexe() goes on from cip as it is
+#endif
+
+#ifdef PROFILE
+	pclear();
+	pline = lend; // no line yet
+	ptick = c_nsec();
+#endif
+	while (*clp) {
+		lp = iexe();
+		if (err)
+			break;
+		clp = lp;
+		cip = clp + 3;
+	}
+#ifdef PROFILE
+	ptime[pline - listbuf] += c_nsec() - ptick;
+	pline = NULL;
+#endif
+}
+
+// LIST command handler
+void ilist() {
+	short lineno;
+
+	lineno = (*cip == I_NUM) ? getlineno(cip) : 0;
+
+	for (clp = getlp(lineno); *clp; clp += *clp) {
+		putnum(getlineno(clp), 0);
+		c_putch(' ');
+		putlist(clp + 3);
+		if (err)
+			break;
+		newline();
+	}
+}
+
+#ifdef PROFILE
+// Compare lines of profile by time, then by offset
+int pcmp(const void* a, const void* b) {
+	unsigned short i = *(const unsigned short*)a, k = *(const unsigned short*)b;
+
+	if (ptime[i] != ptime[k])
+		return ptime[i] < ptime[k] ? 1 : -1;
+	return i - k;
+}
+
+// Show n lines of the profile by time
+void pshow(short n) {
+	unsigned short* ix; // offsets of lines run
+	unsigned long long total = 0;
+	unsigned char* lp;
+	char s[48];
+	short i, k = 0;
+
+	ix = malloc(sizeof(short) * (lcnt + 1));
+	if (ix == NULL)
+		return;
+	for (lp = listbuf; *lp; lp += *lp)
+		if (pcnt[lp - listbuf]) {
+			ix[k++] = lp - listbuf;
+			total += ptime[lp - listbuf];
+		}
+	qsort(ix, k, sizeof(short), pcmp);
+
+	c_puts(" TIME%      COUNT   TIME(us) LINE");
+	newline();
+	for (i = 0; i < k && i < n; i++) {
+		lp = listbuf + ix[i];
+		snprintf(s, sizeof(s), "%6.1f %10lu %10llu ",
+			total ? ptime[ix[i]] * 100.0 / total : 0.0,
+			pcnt[ix[i]], ptime[ix[i]] / 1000);
+		c_puts(s);
+		putnum(getlineno(lp), 0);
+		c_putch(' ');
+		putlist(lp + 3);
+		newline();
+	}
+	free(ix);
+}
+#endif
+
+// PROFILE command handler
+// PROFILE [n]: show n lines(all if omitted) of the last RUN by time
+// (ignored if the build has no PROFILE)
+void iprofile() {
+	short n = 32767;
+
+	if (*cip != I_EOL) {
+		n = eexp();
+		if (err)
+			return;
+		if (*cip != I_EOL) {
+			err = ERR_SYNTAX;
+			return;
+		}
+	}
+#ifdef PROFILE
+	pshow(n);
+#else
+	(void)n;
+#endif
+}
+
+// STATS command handler
+// Show runtime counters since start, as JSON if j
+// Most used and size of GOSUB, FOR and list, input in us
+// A BENCH build adds statements by i-code
+void istats(char j) {
+	const char* name[] = {"lookup", "scan", "gosub", "for", "list", "output", "input_us"};
+	unsigned long long v[] = {ctr.lookup, ctr.scan, ctr.gmax / 2, ctr.fmax,
+		ctr.lpeak, ctr.out, ctr.inwait / 1000};
+	unsigned long long m[] = {0, 0, gsize / 2 - 1, lstkmax, lsize, 0, 0};
+	char s[64];
+	short i, k;
+
+	if (j)
+		c_putch('{');
+	for (i = 0; i < 7; i++) {
+		if (j) {
+			snprintf(s, sizeof(s), "%s\"%s\":%llu", i ? "," : "", name[i], v[i]);
+			if (m[i])
+				snprintf(s + strlen(s), sizeof(s) - strlen(s), ",\"%s_size\":%llu", name[i], m[i]);
+		}
+		else {
+			for (k = 0; name[i][k]; k++)
+				s[k] = c_toupper(name[i][k]);
+			snprintf(s + k, sizeof(s) - k, " %llu", v[i]);
+			if (m[i])
+				snprintf(s + strlen(s), sizeof(s) - strlen(s), "/%llu", m[i]);
+		}
+		c_puts(s);
+		if (!j)
+			newline();
+	}
+#ifdef BENCH
+	if (j)
+		c_puts(",\"stmts\":{");
+	for (i = 0, k = 0; i < 256; i++)
+		if (nstmt[i]) {
+			if (j)
+				c_puts(k++ ? ",\"" : "\"");
+			else
+				c_puts("STMT ");
+			c_puts(iname(i));
+			snprintf(s, sizeof(s), j ? "\":%lu" : " %lu", nstmt[i]);
+			c_puts(s);
+			if (!j)
+				newline();
+		}
+	if (j)
+		c_putch('}');
+#endif
+	if (j) {
+		c_putch('}');
+		c_putch('\n');
+	}
+}
+
+// Show last n records of trace, oldest first
+void tshow(unsigned short n) {
+	unsigned long i;
+	unsigned int r;
+
+	if (n > SIZE_TRACE)
+		n = SIZE_TRACE;
+	if (n > trn)
+		n = trn;
+	for (i = trn - n; i < trn; i++) {
+		r = trbuf[i & (SIZE_TRACE - 1)];
+		putnum(r >> 8, 6);
+		c_putch(' ');
+		c_puts(iname(r & 255));
+		newline();
+	}
+}
+
+// TRACE command handler
+// TRACE [n]: show last n(all if omitted) statements traced by TRON
+void itrace() {
+	short n = SIZE_TRACE;
+
+	if (*cip != I_EOL) {
+		n = eexp();
+		if (err)
+			return;
+		if (*cip != I_EOL) {
+			err = ERR_SYNTAX;
+			return;
+		}
+	}
+	if (n > 0)
+		tshow(n);
+}
+
+//NEW command handler
+void inew(void) {
+	short i;
 
 	for (i = 0; i < 26; i++)
 		var[i] = 0;
-	for (i = 0; i < SIZE_ARRY; i++)
+	for (i = 0; i < asize; i++)
 		arr[i] = 0;
 	gstki = 0;
 	lstki = 0;
 	*listbuf = 0;
 	clp = listbuf;
+	linked = 0;
+	mkindex();
+	eclear();
+}
+
+// Line of LOAD
+typedef struct {
+	short lineno;
+	unsigned short seq; //Order in the file
+	unsigned char* ip; //i-code
+} ldline;
+
+// Compare lines of LOAD by line number, the last one comes last
+int ldcmp(const void* a, const void* b) {
+	const ldline* p = a;
+	const ldline* q = b;
+
+	if (p->lineno != q->lineno)
+		return p->lineno < q->lineno ? -1 : 1;
+	return p->seq < q->seq ? -1 : 1;
+}
+
+// Program image
+// SAVE writes the list to a file as it is in memory, and LOAD maps it
+// back. The list starts at IMG_HEAD of the file, so its whole pages are
+// mapped into listbuf and shared with the page cache until written.
+// SAVE replaces the file by rename, so a mapped image never changes.
+// A checkpoint is an image with the run state after the list
+#define IMG_MAGIC "TTBASIC\032" //Magic of image(8 bytes)
+#define IMG_VER 3 //Version of image
+#define IMG_HEAD 4096 //Offset of the list in image
+
+// Image header
+typedef struct {
+	char magic[8]; //IMG_MAGIC
+	unsigned short ver; //IMG_VER in byte order of the writer
+	unsigned short vsize; //Bytes of a value
+	unsigned int kwsum; //imgsum() of the writer
+	unsigned int size; //List bytes with the end 0
+	unsigned int state; //Offset of run state, 0 if none
+} imghead;
+
+// Run state of checkpoint, followed by arr[asize], gstk[CKGSTK(gstki)] and
+// lstki ckframe, pointers are offsets in the list
+// gstk is padded to align ckframe of wide values
+#define CKGSTK(n) (((n) + NUM_SIZE / 2 - 1) & ~(NUM_SIZE / 2 - 1))
+typedef struct {
+	unsigned short asize; //Array cells
+	unsigned short clp, cip; //Where to resume
+	unsigned short gstki, lstki; //GOSUB(2/nest) and FOR stack index
+	unsigned short rstati; //Rear tap of RND generator
+	num var[26];
+	uint32_t rstate[RND_DEG]; //State of RND generator
+} ckstate;
+
+// FOR stack frame of checkpoint
+typedef struct {
+	short v; //Variable index
+	num vto, vstep; //TO and STEP value
+	unsigned short lp, ip; //Loop point
+} ckframe;
+
+TLS const char* ckfile; //Checkpoint file(-c), NULL if none
+
+// Return FNV-1a of keywords and i-code numbers
+// An image works only with the same
+unsigned int imgsum() {
+	const unsigned char icode[] = {I_NUM, I_VAR, I_STR, I_LNK, I_EOL};
+	const unsigned char* s;
+	unsigned int h = 2166136261u;
+	short i;
+
+	for (i = 0; i < I_NUM; i++)
+		for (s = (const unsigned char*)kwtbl[i]; ; s++) {
+			h = (h ^ *s) * 16777619u;
+			if (*s == 0)
+				break;
+		}
+	for (i = 0; i < (short)sizeof(icode); i++)
+		h = (h ^ icode[i]) * 16777619u;
+	return h;
+}
+
+// Return 1 if p is a list of size bytes that LIST and RUN can take
+char imgok(const unsigned char* p, unsigned int size) {
+	const unsigned char *lp, *ip, *e;
+	short lineno, prev = 0;
+
+	if (size == 0 || p[size - 1])
+		return 0;
+	for (lp = p; *lp; lp += *lp) {
+		if (*lp < 5 || lp + *lp > p + size - 1)
+			return 0; // no statement or out of the list
+		lineno = getlineno((unsigned char*)lp);
+		if (lineno <= prev)
+			return 0; // not in order
+		prev = lineno;
+		e = lp + *lp - 1;
+		if (*e != I_EOL)
+			return 0;
+		for (ip = lp + 3; ip < e; ip = nexti((unsigned char*)ip))
+			if (*ip >= I_LNK || (*ip == I_VAR && *(ip + 1) >= 26))
+				return 0; // not made by toktoi()
+		if (ip != e)
+			return 0;
+	}
+	return lp == p + size - 1;
+}
+
+// Return 1 if lp and ip of the list are a line and a position in it
+char ckat(unsigned short lp, unsigned short ip) {
+	short li;
+
+	if (lp >= lend - listbuf)
+		return 0;
+	li = getli(getlineno(listbuf + lp));
+	return li < lcnt && lidx[li] == lp && ip >= lp + 3 &&
+		ip < lp + *(listbuf + lp);
+}
+
+// Set the run state of checkpoint st of n bytes
+// Return 0 if it does not fit the list or the sizes
+char ckset(const char* st, size_t n) {
+	const ckstate* c = (const ckstate*)st;
+	const unsigned short* g;
+	const ckframe* f;
+	short i;
+
+	if (n < sizeof(ckstate) || c->asize > asize || c->gstki >= gsize - 1 ||
+		c->gstki & 1 || c->lstki > lstkmax || c->rstati >= RND_DEG ||
+		n != sizeof(ckstate) + sizeof(num) * c->asize +
+		sizeof(short) * CKGSTK(c->gstki) + sizeof(ckframe) * c->lstki ||
+		!ckat(c->clp, c->cip))
+		return 0;
+	g = (const unsigned short*)(st + sizeof(ckstate) + sizeof(num) * c->asize);
+	f = (const ckframe*)(g + CKGSTK(c->gstki));
+	for (i = 0; i < c->gstki; i += 2)
+		if (!ckat(g[i], g[i + 1]))
+			return 0;
+	for (i = 0; i < c->lstki; i++)
+		if (f[i].v < 0 || f[i].v >= 26 || !ckat(f[i].lp, f[i].ip))
+			return 0;
+	while (lstkn < c->lstki)
+		if (!lgrow())
+			return 0;
+
+	memcpy(var, c->var, sizeof(var));
+	memcpy(arr, st + sizeof(ckstate), sizeof(num) * c->asize);
+	for (gstki = 0; gstki < c->gstki; gstki++) {
+		gstk[gstki] = listbuf + g[gstki];
+		gstkp[gstki >> 1] = NULL; // iexe() made
+	}
+	for (lstki = 0; lstki < c->lstki; lstki++) {
+		lstk[lstki].vp = var + f[lstki].v;
+		lstk[lstki].vto = f[lstki].vto;
+		lstk[lstki].vstep = f[lstki].vstep;
+		lstk[lstki].pc = NULL; // iexe() made
+		lstk[lstki].lp = listbuf + f[lstki].lp;
+		lstk[lstki].ip = listbuf + f[lstki].ip;
+	}
+	memcpy(rstate, c->rstate, sizeof(rstate));
+	rstati = c->rstati;
+	clp = listbuf + c->clp;
+	cip = listbuf + c->cip;
+	return 1;
+}
+
+// Load the image of fd, and the run state if resume
+// Return 0 if not an image, or 1 with err set if it can not be loaded
+char iimage(int fd, off_t fsize, char resume) {
+	imghead h;
+	unsigned char* p;
+	char* st;
+	size_t n;
+	long pg;
+
+	if (fsize < IMG_HEAD || pread(fd, &h, sizeof(h), 0) != sizeof(h) ||
+		memcmp(h.magic, IMG_MAGIC, 8))
+		return 0;
+	if (h.ver != IMG_VER || h.vsize != sizeof(num) ||
+		h.kwsum != imgsum() || h.size > fsize - IMG_HEAD ||
+		h.state > fsize || (resume && h.state == 0)) {
+		err = ERR_IMG; // by other version or build
+		return 1;
+	}
+	if (h.size > (unsigned int)lsize) {
+		err = ERR_LBUFOF;
+		return 1;
+	}
+	p = mmap(NULL, h.size, PROT_READ, MAP_PRIVATE, fd, IMG_HEAD);
+	if (p == MAP_FAILED) {
+		err = ERR_FILE;
+		return 1;
+	}
+	if (!imgok(p, h.size)) {
+		munmap(p, h.size);
+		err = ERR_IMG;
+		return 1;
+	}
+
+	// Map whole pages over listbuf, copy the rest
+	pg = sysconf(_SC_PAGESIZE);
+	n = h.size & ~(size_t)(pg - 1);
+	if (IMG_HEAD % pg || (uintptr_t)listbuf % pg || (n &&
+		mmap(listbuf, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+			fd, IMG_HEAD) == MAP_FAILED))
+		n = 0;
+	memcpy(listbuf + n, p + n, h.size - n);
+	munmap(p, h.size);
+	clp = listbuf;
+	linked = 0;
+	mkindex();
+	eclear();
+
+	if (resume) {
+		n = fsize - h.state;
+		st = malloc(n);
+		if (st == NULL || pread(fd, st, n, h.state) != (ssize_t)n || !ckset(st, n))
+			err = ERR_IMG;
+		free(st);
+	}
+	return 1;
+}
+
+// Copy the list to p without I_LNK
+void lcopy(unsigned char* p) {
+	unsigned char* ip;
+	short lineno;
+
+	memcpy(p, listbuf, lend - listbuf + 1);
+	if (!linked)
+		return;
+	for (; *p; p += *p)
+		for (ip = p + 3; *ip != I_EOL; ip = nexti(ip)) {
+			if (*ip != I_LNK)
+				continue;
+			lineno = getlineno(listbuf + (*(ip + 1) | *(ip + 2) << 8));
+			*ip = I_NUM;
+			*(ip + 1) = lineno & 255;
+			*(ip + 2) = lineno >> 8;
+		}
+}
+
+// Return offset of p in the list, or -1 if not in it
+long ckoff(unsigned char* p) {
+	return p >= listbuf && p < lend ? p - listbuf : -1;
+}
+
+// Write the image to a new file then rename it to name, with the run
+// state if state. Return 0 if failed
+char imgwrite(const char* name, char state) {
+	char tmp[4096];
+	imghead* h;
+	ckstate* c;
+	unsigned short* g;
+	ckframe* f;
+	char* buf;
+	size_t n, size;
+	int fd;
+	short i;
+	char ok;
+
+	size = lend - listbuf + 1;
+	n = IMG_HEAD + ((size + 7) & ~(size_t)7);
+	if (state)
+		n += sizeof(ckstate) + sizeof(num) * asize +
+			sizeof(short) * CKGSTK(gstki) + sizeof(ckframe) * lstki;
+	buf = calloc(n, 1);
+	if (buf == NULL)
+		return 0;
+	h = (imghead*)buf;
+	memcpy(h->magic, IMG_MAGIC, 8);
+	h->ver = IMG_VER;
+	h->vsize = sizeof(num);
+	h->kwsum = imgsum();
+	h->size = size;
+	lcopy((unsigned char*)buf + IMG_HEAD);
+
+	if (state) { // pointers go as offsets, see ckset()
+		h->state = IMG_HEAD + ((size + 7) & ~(size_t)7);
+		c = (ckstate*)(buf + h->state);
+		c->asize = asize;
+		c->clp = ckoff(clp);
+		c->cip = ckoff(cip);
+		c->gstki = gstki;
+		c->lstki = lstki;
+		c->rstati = rstati;
+		memcpy(c->var, var, sizeof(var));
+		memcpy(c->rstate, rstate, sizeof(rstate));
+		memcpy(c + 1, arr, sizeof(num) * asize);
+		g = (unsigned short*)((char*)(c + 1) + sizeof(num) * asize);
+		for (i = 0; i < gstki; i++)
+			g[i] = ckoff(gstk[i]);
+		f = (ckframe*)(g + CKGSTK(gstki));
+		for (i = 0; i < lstki; i++) {
+			f[i].v = lstk[i].vp - var;
+			f[i].vto = lstk[i].vto;
+			f[i].vstep = lstk[i].vstep;
+			f[i].lp = ckoff(lstk[i].lp);
+			f[i].ip = ckoff(lstk[i].ip);
+		}
+	}
+
+	snprintf(tmp, sizeof(tmp), "%s.XXXXXX", name);
+	fd = mkstemp(tmp);
+	ok = fd >= 0 && write(fd, buf, n) == (ssize_t)n && fchmod(fd, 0644) == 0;
+	if (fd >= 0)
+		close(fd);
+	if (fd >= 0 && (!ok || rename(tmp, name) < 0)) {
+		unlink(tmp);
+		ok = 0;
+	}
+	free(buf);
+	return ok;
+}
+
+// SAVE command handler
+void isave(const char* name) {
+	if (!imgwrite(name, 0))
+		err = ERR_FILE;
+}
+
+// Checkpoint
+// Taken at a statement by CHECKPOINT, or at the next jump after SIGUSR1
+// or every ckint seconds, to ckfile. ttbasic -r -c file resumes from it.
+// Nothing is taken out of the list(direct command)
+void icheck() {
+	short i;
+
+	ckreq = 0;
+	if (ckfile == NULL)
+		return;
+	if (ckoff(clp) < 0 || ckoff(cip) < 0)
+		return; // direct
+	for (i = 0; i < gstki; i++)
+		if (ckoff(gstk[i]) < 0)
+			return; // GOSUB by direct
+	for (i = 0; i < lstki; i++)
+		if (ckoff(lstk[i].ip) < 0)
+			return; // FOR by direct
+	c_flush(); // resume goes on after the output so far
+	imgwrite(ckfile, 1);
+}
+
+// Resume the run of the checkpoint file
+// Return 0 if no file
+char iresume(const char* name) {
+	int fd;
+	struct stat st;
+
+	fd = open(name, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	if (fstat(fd, &st) < 0 || !iimage(fd, st.st_size, 1))
+		err = ERR_IMG;
+	close(fd);
+	if (err)
+		return 1;
+	ilink();
+	if (!err)
+		igo(1);
+	return 1;
+}
+
+// LOAD command handler
+// Read the whole file, convert all lines, then sort them into the list
+// Direct or too long lines are errors, and leave the list unchanged
+// An image made by SAVE is mapped instead
+void iload(const char* name) {
+	int fd;
+	struct stat st;
+	char* src; // file image
+	char* s; // line
+	char* e; // end of line
+	unsigned char* icode; // i-code of lines
+	unsigned char* ip;
+	ldline* ld; // lines to sort
+	int n, i, size;
+	unsigned char len;
+
+	fd = open(name, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		if (fd >= 0)
+			close(fd);
+		err = ERR_FILE;
+		return;
+	}
+	if (iimage(fd, st.st_size, 0)) {
+		close(fd);
+		return;
+	}
+	src = malloc(st.st_size + 1);
+	if (src == NULL || read(fd, src, st.st_size) != st.st_size) {
+		free(src);
+		close(fd);
+		err = ERR_FILE;
+		return;
+	}
+	close(fd);
+	src[st.st_size] = 0;
+
+	// Count lines for work area
+	for (n = 1, s = src; *s; s++)
+		if (*s == '\n')
+			n++;
+	icode = malloc(n * SIZE_IBUF);
+	ld = malloc(n * sizeof(ldline));
+	if (icode == NULL || ld == NULL || n > 65535) {
+		free(icode);
+		free(ld);
+		free(src);
+		err = ERR_LBUFOF;
+		return;
+	}
+
+	// Convert
+	ip = icode;
+	n = 0;
+	for (s = src; *s; s = e) {
+		for (e = s; *e && *e != '\n'; e++);
+		if (*e)
+			*e++ = 0;
+		for (i = strlen(s) - 1; i >= 0 && c_isspace(s[i]); i--) // Skip space
+			s[i] = 0;
+		while (c_isspace(*s))
+			s++;
+		if (*s == 0)
+			continue;
+
+		len = toktoi(s);
+		if (!err && *ibuf != I_NUM)
+			err = ERR_SYNTAX; // direct in the file
+		if (err) {
+			for (i = 0; i < SIZE_LINE - 1 && s[i]; i++) // show the line
+				lbuf[i] = s[i];
+			lbuf[i] = 0;
+			break;
+		}
+		*ibuf = len;
+		for (i = 0; i < len; i++)
+			ip[i] = ibuf[i];
+		ld[n].lineno = getlineno(ip);
+		ld[n].seq = n;
+		ld[n++].ip = ip;
+		ip += len;
+	}
+
+	// Sort, the last line of the same number takes place
+	if (!err) {
+		qsort(ld, n, sizeof(ldline), ldcmp);
+		size = 0;
+		for (i = 0; i < n; i++)
+			if ((i == n - 1 || ld[i + 1].lineno != ld[i].lineno) && *ld[i].ip > 4)
+				size += *ld[i].ip;
+			else
+				ld[i].ip = NULL; // replaced or deleted
+		if (size > lsize - 1)
+			err = ERR_LBUFOF;
+	}
+
+	// Build list
+	if (!err) {
+		ip = listbuf;
+		for (i = 0; i < n; i++)
+			if (ld[i].ip) {
+				memcpy(ip, ld[i].ip, *ld[i].ip);
+				ip += *ld[i].ip;
+			}
+		*ip = 0;
+		clp = listbuf;
+		linked = 0;
+		mkindex();
+		eclear();
+	}
+
+	free(ld);
+	free(icode);
+	free(src);
 }
 
 //Command precessor
 void icom() {
 	cip = ibuf;
+	c_kbstart(); // Watch abort key while execute
 	switch (*cip) {
 	case I_NEW:
 		cip++;
@@ -1216,7 +4144,7 @@ void icom() {
 		break;
 	case I_LIST:
 		cip++;
-		if (*cip == I_EOL || *(cip + 3) == I_EOL)
+		if (*cip == I_EOL || *(cip + 1 + NUM_SIZE) == I_EOL)
 			ilist();
 		else
 			err = ERR_SYNTAX;
@@ -1225,18 +4153,50 @@ void icom() {
 		cip++;
 		irun();
 		break;
+	case I_LOAD:
+	case I_SAVE:
+		cip++;
+		if (*cip == I_STR && *(cip + 2 + *(cip + 1)) == I_EOL) {
+			*(cip + 2 + *(cip + 1)) = 0; // file name, ibuf is free after open
+			if (*ibuf == I_LOAD)
+				iload((char*)cip + 2);
+			else
+				isave((char*)cip + 2);
+		}
+		else
+			err = ERR_SYNTAX;
+		break;
+	case I_PROFILE:
+		cip++;
+		iprofile();
+		break;
+	case I_TRACE:
+		cip++;
+		itrace();
+		break;
+	case I_STATS:
+		cip++;
+		if (*cip == I_EOL)
+			istats(0);
+		else
+			err = ERR_SYNTAX;
+		break;
 	default:
 		iexe();
 		break;
 	}
+	c_kbstop();
 }
 
 // Print OK or error message
 void error() {
 	if (err) {
-		if (cip >= listbuf && cip < listbuf + SIZE_LIST && *clp)
+		if (cip >= listbuf && cip < listbuf + lsize && *clp)
 		{
-			newline();
+			if (ofd == STDOUT_FILENO)
+				newline();
+			if (tron) // steps to the error
+				tshow(trerr);
 			c_puts("LINE:");
 			putnum(getlineno(clp), 0);
 			c_putch(' ');
@@ -1244,7 +4204,8 @@ void error() {
 		}
 		else
 		{
-			newline();
+			if (ofd == STDOUT_FILENO)
+				newline();
 			c_puts("YOU TYPE: ");
 			c_puts(lbuf);
 		}
@@ -1253,34 +4214,593 @@ void error() {
 	newline();
 	c_puts(errmsg[err]);
 	newline();
+	c_flush();
 	err = 0;
 }
 
+// Arena
+// All areas sized by lsize, asize and gsize come from 1 mapping, made
+// once at start. Pages are reserved and given by the system when touched,
+// so an area grows in place and pointers to it stay valid
+TLS uintptr_t aend; //End of areas laid out
+
+// Take an area of size bytes
+void* acarve(size_t size) {
+	void* p = (void*)aend;
+
+	aend += (size + 15) & ~(size_t)15;
+	return p;
+}
+
+// Lay out areas from base, return the end
+uintptr_t alay(uintptr_t base) {
+	aend = base;
+	listbuf = acarve(lsize);
+	lidx = acarve(sizeof(short) * (lsize / 4 + 1));
+	arr = acarve(sizeof(num) * asize);
+	gstk = acarve(sizeof(unsigned char*) * gsize);
+	gstkp = acarve(sizeof(num*) * (gsize / 2));
+#ifndef NO_ECACHE
+	ecode = acarve(sizeof(num) * SIZE_ECODE);
+	eidx = acarve(sizeof(short) * lsize);
+#endif
+#ifndef NO_VM
+	code = acarve(sizeof(num) * SIZE_CODE);
+	lpc = acarve(sizeof(short) * (lsize / 4 + 1));
+	xpc = acarve(sizeof(short) * (lsize / 2));
+	xip = acarve(sizeof(short) * (lsize / 2));
+#endif
+#ifdef PROFILE
+	pcnt = acarve(sizeof(unsigned long) * lsize);
+	ptime = acarve(sizeof(unsigned long long) * lsize);
+#endif
+#ifdef JIT
+	jent = acarve(sizeof(jitfn) * SIZE_CODE);
+	jcnt = acarve(sizeof(short) * SIZE_CODE);
+	jlab = acarve(sizeof(int) * SIZE_CODE);
+#endif
+	return aend;
+}
+
+// Make the arena
+// Return 0 if no memory
+char arena() {
+	void* p;
+
+	p = mmap(NULL, alay(0), PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (p == MAP_FAILED)
+		return 0;
+	alay((uintptr_t)p);
+	return 1;
+}
+
+// Set size of area by option c(l: list, a: array, g: GOSUB, f: FOR)
+// GOSUB and FOR are in nests, return 0 if wrong
+char setsize(char c, const char* s) {
+	long n;
+	char* e;
+
+	n = strtol(s, &e, 10);
+	if (*s == 0 || *e || n < 1 || n > 32767)
+		return 0;
+	switch (c) {
+	case 'l':
+		lsize = n < 16 ? 16 : n;
+		break;
+	case 'a':
+		asize = n;
+		break;
+	case 'g':
+		if (n > 255)
+			return 0;
+		gsize = (n + 1) * 2; // last 2 are not used
+		break;
+	case 'f':
+		lstkmax = n;
+		break;
+	default:
+		return 0;
+	}
+	return 1;
+}
+
+/*
+TOYOSHIKI Tiny BASIC
+Interpreter of a thread
+*/
+// A thread makes its interpreter by bopen(), runs programs by brun() and
+// frees it by bclose(). Sizes(setsize()), jithot, opt and tron of the
+// thread are set before bopen()
+
+// Make the interpreter, d is its device(NULL: terminal), seed is of RND
+// Return 0 if no memory
+char bopen(bdev* d, unsigned int seed) {
+	dev = d;
+	otty = d == NULL && isatty(STDOUT_FILENO);
+	lstk = lstk0;
+	lstkn = lstkmax < SIZE_LSTK ? lstkmax : SIZE_LSTK; // lstkmax may be less
+	if (!arena())
+		return 0;
+	c_srand(seed);
+	inew();
+	return 1;
+}
+
+// Load the file and run it, the error message goes to stderr
+// With ckfile, resume from it if any, and remove it at the end
+// Return exit status, 1 if error
+int brun(const char* name) {
+	trerr = SIZE_TRACE;
+	ieof = 0; // input of this program
+	snprintf(lbuf, SIZE_LINE, "%s", name); // shown if not found
+	if (ckint)
+		c_kbstart(); // checkpoint timer
+	if (ckfile == NULL || !iresume(ckfile)) {
+		iload(name);
+		if (!err)
+			irun();
+	}
+	if (ckint)
+		c_kbstop();
+	c_flush();
+	if (!err) {
+		if (ckfile)
+			unlink(ckfile); // done, nothing to resume
+		return 0;
+	}
+	ofd = STDERR_FILENO;
+	error();
+	ofd = STDOUT_FILENO;
+	return 1;
+}
+
+// Free the interpreter
+void bclose() {
+	c_flush();
+	munmap(listbuf, aend - (uintptr_t)listbuf);
+#ifdef JIT
+	if (jbuf)
+		munmap(jbuf, SIZE_JIT);
+	jbuf = NULL;
+#endif
+	if (lstk != lstk0)
+		free(lstk);
+	lstk = lstk0;
+	lstkn = SIZE_LSTK;
+	dev = NULL;
+}
+
+/*
+TOYOSHIKI Tiny BASIC
+Parallel batch runner
+*/
+// ttbasic -p threads [-o dir] file or directory...
+// Runs each file(the .bas files of a directory) by brun() on threads,
+// an interpreter per job. file.in beside file.bas is its input if any.
+// Each thread takes jobs from the top of its own range, and from the
+// bottom of the others' when it is empty. Output goes to dir/name.out
+// and dir/name.err. 1 JSON line per job in order of the files, then 1 of
+// the total, go to stdout
+
+// Job
+typedef struct {
+	char* name; //File
+	char* in; //Input, NULL if none
+	size_t inn, ini; //Input size and index
+	char* out[2]; //stdout and stderr kept for dir
+	size_t outn[2], outz[2]; //Bytes written and kept size
+	unsigned int hash; //FNV-1a of stdout
+	unsigned int seed; //Seed of RND
+	double wall; //Seconds
+	int status; //Exit status, 1 if error
+} pjob;
+
+// Jobs of a thread, [lo, hi) of pjobs
+typedef struct {
+	pthread_mutex_t m;
+	int lo, hi;
+} pqueue;
+
+pjob* pjobs; //Jobs
+int pjn; //Job count
+pqueue* pq; //Jobs of threads
+int pqn; //Thread count
+const char* pdir; //Output directory, NULL to keep no output
+short psize[3]; //lsize, asize and gsize of the interpreters
+unsigned short pfor, pjit; //lstkmax and jithot
+unsigned char popt, ptron; //opt and tron
+
+// Read the whole file, return NULL if not found
+char* pfile(const char* name, size_t* n) {
+	int fd;
+	struct stat st;
+	char* p = NULL;
+
+	fd = open(name, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) == 0 && (p = malloc(st.st_size + 1)))
+		if (read(fd, p, st.st_size) != st.st_size) {
+			free(p);
+			p = NULL;
+		}
+	close(fd);
+	*n = p ? st.st_size : 0;
+	return p;
+}
+
+// Device of a job
+int pgetch(void* arg) {
+	pjob* j = arg;
+
+	return j->ini < j->inn ? (unsigned char)j->in[j->ini++] : EOF;
+}
+
+int pput(void* arg, int fd, const char* s, int n) {
+	pjob* j = arg;
+	int k = fd == STDERR_FILENO, i;
+	char* p;
+
+	if (!k)
+		for (i = 0; i < n; i++)
+			j->hash = (j->hash ^ (unsigned char)s[i]) * 16777619u;
+	if (pdir) {
+		if (j->outn[k] + n > j->outz[k]) {
+			p = realloc(j->out[k], (j->outn[k] + n) * 2);
+			if (p == NULL)
+				return -1;
+			j->out[k] = p;
+			j->outz[k] = (j->outn[k] + n) * 2;
+		}
+		memcpy(j->out[k] + j->outn[k], s, n);
+	}
+	j->outn[k] += n;
+	return n;
+}
+
+// Write n bytes of s to dir/name of the job with extension x
+void pkeep(pjob* j, const char* x, const char* s, size_t n) {
+	char path[4096];
+	const char* b;
+	int fd, k;
+
+	b = strrchr(j->name, '/');
+	b = b ? b + 1 : j->name;
+	k = strlen(b);
+	if (k > 4 && !strcmp(b + k - 4, ".bas"))
+		k -= 4;
+	snprintf(path, sizeof(path), "%s/%.*s%s", pdir, k, b, x);
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return;
+	if (write(fd, s, n) < 0)
+		j->status = 1;
+	close(fd);
+}
+
+// Run a job
+void pjob1(pjob* j) {
+	bdev d = {pgetch, pput, j};
+	unsigned long long t = c_nsec();
+
+	j->hash = 2166136261u;
+	j->status = 1;
+	if (bopen(&d, j->seed)) {
+		j->status = brun(j->name);
+		bclose();
+	}
+	else
+		pput(j, STDERR_FILENO, "no memory\n", 10);
+	j->wall = (c_nsec() - t) / 1e9;
+	if (pdir) {
+		pkeep(j, ".out", j->out[0], j->outn[0]);
+		pkeep(j, ".err", j->out[1], j->outn[1]);
+	}
+	free(j->out[0]);
+	free(j->out[1]);
+	free(j->in);
+}
+
+// Take a job for thread i, return -1 if no more
+int ptake(int i) {
+	pqueue* q;
+	int k, r;
+
+	for (r = 0; r < pqn; r++) {
+		q = &pq[(i + r) % pqn];
+		pthread_mutex_lock(&q->m);
+		k = q->lo < q->hi ? (r ? q->lo++ : --q->hi) : -1;
+		pthread_mutex_unlock(&q->m);
+		if (k >= 0)
+			return k;
+	}
+	return -1;
+}
+
+// Thread of the runner
+void* pwork(void* arg) {
+	int i = (pqueue*)arg - pq, k;
+
+	lsize = psize[0];
+	asize = psize[1];
+	gsize = psize[2];
+	lstkmax = pfor;
+	jithot = pjit;
+	opt = popt;
+	while ((k = ptake(i)) >= 0) {
+		tron = ptron;
+		pjob1(&pjobs[k]);
+	}
+	return NULL;
+}
+
+// Add file as a job
+void padd(const char* file) {
+	pjob* p;
+	char* s;
+	size_t n;
+
+	p = realloc(pjobs, sizeof(pjob) * (pjn + 1));
+	s = malloc(strlen(file) + 4);
+	if (p == NULL || s == NULL) {
+		fprintf(stderr, "no memory\n");
+		exit(1);
+	}
+	pjobs = p;
+	memset(&pjobs[pjn], 0, sizeof(pjob));
+	pjobs[pjn].name = strcpy(s, file);
+	n = strlen(s);
+	if (n > 4 && !strcmp(s + n - 4, ".bas"))
+		n -= 4;
+	strcpy(s + n, ".in"); // input beside
+	pjobs[pjn].in = pfile(s, &pjobs[pjn].inn);
+	strcpy(s, file);
+	pjobs[pjn].seed = rand();
+	pjn++;
+}
+
+// Print s as a JSON string
+void pstr(const char* s) {
+	putchar('"');
+	for (; *s; s++)
+		if (*s == '"' || *s == '\\')
+			printf("\\%c", *s);
+		else if ((unsigned char)*s < ' ')
+			printf("\\u%04x", *s);
+		else
+			putchar(*s);
+	putchar('"');
+}
+
+// Compare file names
+int pncmp(const void* a, const void* b) {
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Add a file, or the .bas files of a directory in order of names
+void padds(const char* name) {
+	DIR* d;
+	struct dirent* e;
+	char** v = NULL;
+	int n = 0, i, k;
+
+	d = opendir(name);
+	if (d == NULL) {
+		padd(name);
+		return;
+	}
+	while ((e = readdir(d))) {
+		k = strlen(e->d_name);
+		if (k <= 4 || strcmp(e->d_name + k - 4, ".bas"))
+			continue;
+		v = realloc(v, sizeof(char*) * (n + 1));
+		v[n] = malloc(strlen(name) + k + 2);
+		sprintf(v[n++], "%s/%s", name, e->d_name);
+	}
+	closedir(d);
+	qsort(v, n, sizeof(char*), pncmp);
+	for (i = 0; i < n; i++) {
+		padd(v[i]);
+		free(v[i]);
+	}
+	free(v);
+}
+
+// Run files of argv on threads(0: cores), seed is of RND if given
+// Return exit status, 1 if any job failed
+int prunall(int threads, char** argv, int argc, const unsigned int* seed) {
+	pthread_t* t;
+	unsigned long long t0;
+	double wall;
+	int i, k, bad = 0;
+
+	for (i = 0; i < argc; i++)
+		padds(argv[i]);
+	if (seed)
+		for (i = 0; i < pjn; i++)
+			pjobs[i].seed = *seed;
+	if (threads < 1)
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+	pqn = threads > pjn ? pjn : threads;
+	if (pqn < 1)
+		pqn = 1;
+	pq = calloc(pqn, sizeof(pqueue));
+	t = calloc(pqn, sizeof(pthread_t));
+	if (pq == NULL || t == NULL) {
+		fprintf(stderr, "no memory\n");
+		return 1;
+	}
+	psize[0] = lsize;
+	psize[1] = asize;
+	psize[2] = gsize;
+	pfor = lstkmax;
+	pjit = jithot;
+	popt = opt;
+	ptron = tron;
+
+	t0 = c_nsec();
+	for (i = 0; i < pqn; i++) { // a range each
+		pthread_mutex_init(&pq[i].m, NULL);
+		pq[i].lo = (long)pjn * i / pqn;
+		pq[i].hi = (long)pjn * (i + 1) / pqn;
+	}
+	for (k = 0; k < pqn; k++)
+		if (pthread_create(&t[k], NULL, pwork, &pq[k]))
+			break;
+	if (k == 0)
+		pwork(&pq[0]); // no thread, run here
+	for (i = 0; i < k; i++)
+		pthread_join(t[i], NULL);
+	wall = (c_nsec() - t0) / 1e9;
+
+	for (i = 0; i < pjn; i++) {
+		printf("{\"name\":");
+		pstr(pjobs[i].name);
+		printf(",\"status\":%d,\"wall_s\":%.6f,"
+			"\"out_bytes\":%zu,\"err_bytes\":%zu,\"out\":\"%08x\"}\n",
+			pjobs[i].status, pjobs[i].wall,
+			pjobs[i].outn[0], pjobs[i].outn[1], pjobs[i].hash);
+		bad += pjobs[i].status != 0;
+		free(pjobs[i].name);
+	}
+	printf("{\"jobs\":%d,\"failed\":%d,\"threads\":%d,\"wall_s\":%.6f,\"jobs_s\":%.1f}\n",
+		pjn, bad, pqn, wall, wall > 0 ? pjn / wall : 0);
+	free(pjobs);
+	free(pq);
+	free(t);
+	return bad != 0;
+}
+
 /*
 TOYOSHIKI Tiny BASIC
 The BASIC entry point
 */
-void basic(){
+// ttbasic [-r] [-t] [-s seed] [-j file] [-c file [-i sec]] [-l list] [-a array] [-g gosub] [-f for] [file]
+// or ttbasic -p threads [-o dir] [options] file or directory...
+// or TTBASIC_LIST, TTBASIC_ARRAY, TTBASIC_GOSUB, TTBASIC_FOR
+// -r runs the file without banner and prompt, error message to stderr
+// -t starts with TRON, -r shows all the trace at error
+// -s fixes the seed of RND
+// -j writes STATS as JSON to the file(- is stderr) at exit of -r
+// -c takes checkpoints to the file by CHECKPOINT, SIGUSR1 or every -i sec,
+// and -r resumes from it, see icheck()
+// -p runs files on threads(0: cores), -o keeps their output, see prunall()
+// Return exit status, 1 if error in -r
+int basic(int argc, char** argv){
 	unsigned char len;
+	const char* env[] = {"TTBASIC_LIST", "TTBASIC_ARRAY", "TTBASIC_GOSUB", "TTBASIC_FOR"};
+	char* s;
+	int c;
+	char batch = 0; // -r
+	char* json = NULL; // -j
+	unsigned int seed = rand(); // -s
+	char seeded = 0;
+	int threads = -1; // -p
+
+	for(c = 0; c < 4; c++) // Sizes by environment
+		if((s = getenv(env[c])) && !setsize("lagf"[c], s)){
+			fprintf(stderr, "%s: wrong size\n", env[c]);
+			exit(1);
+		}
+	while((c = getopt(argc, argv, "rts:j:p:o:c:i:l:a:g:f:")) != -1) // Sizes by options
+		if(c == 'r')
+			batch = 1;
+		else
+		if(c == 't')
+			tron = 1;
+		else
+		if(c == 'j')
+			json = optarg;
+		else
+		if(c == 's'){
+			seed = strtoul(optarg, NULL, 10);
+			seeded = 1;
+		}
+		else
+		if(c == 'p')
+			threads = atoi(optarg);
+		else
+		if(c == 'o')
+			pdir = optarg;
+		else
+		if(c == 'c')
+			ckfile = optarg;
+		else
+		if(c == 'i')
+			ckint = atoi(optarg);
+		else
+		if(c == '?' || !setsize(c, optarg)){
+			batch = 2; // usage
+			break;
+		}
+	if(batch == 2 || ((batch || threads >= 0) && optind >= argc)){
+		fprintf(stderr, "usage: %s [-r] [-t] [-s seed] [-j file] [-c file [-i sec]] [-l list] [-a array] [-g gosub] [-f for] [file]\n"
+			"       %s -p threads [-o dir] [options] file or directory...\n", argv[0], argv[0]);
+		exit(1);
+	}
+	if(ckfile == NULL)
+		ckint = 0;
+	else
+		signal(SIGUSR1, cksig);
+	if(threads >= 0) // Run the files in parallel and exit
+		return prunall(threads, argv + optind, argc - optind, seeded ? &seed : NULL);
+	if(!bopen(NULL, seed)){
+		fprintf(stderr, "%s: no memory\n", argv[0]);
+		exit(1);
+	}
+	c_ttystart();
+
+	if(batch){ // Load, run and exit
+		c = brun(argv[optind]);
+#ifdef BENCH
+		fprintf(stderr, "STMTS %lu\n", nstmts());
+#endif
+#ifdef PROFILE
+		ofd = STDERR_FILENO; // profile to stderr
+		pshow(32767);
+		c_flush();
+		ofd = STDOUT_FILENO;
+#endif
+		if(json){ // counters
+			ofd = strcmp(json, "-") ?
+				open(json, O_WRONLY | O_CREAT | O_TRUNC, 0644) : STDERR_FILENO;
+			if(ofd >= 0){
+				istats(1);
+				c_flush();
+				if(ofd != STDERR_FILENO)
+					close(ofd);
+			}
+			ofd = STDOUT_FILENO;
+		}
+		return c;
+	}
 
-	inew();
 	c_puts("TOYOSHIKI TINY BASIC"); newline();
 	c_puts(STR_EDITION);
 	c_puts(" EDITION"); newline();
+	if(optind < argc) // Load the program
+		iload(argv[optind]);
 	error(); // Print OK, and Clear error flag
 
 	// Input 1 line and execute
 	while(1){
 		c_putch('>');// Prompt
 		c_gets(); // Input 1 line
-		len = toktoi(); // Convert token to i-code
+		if(ieof && !*lbuf){ // End of input
+			newline();
+			c_flush();
+			return 0;
+		}
+		len = toktoi(lbuf); // Convert token to i-code
 		if(err){ // Error
 			error();
 			continue; // Do nothing
 		}
 
 		if(*ibuf == I_SYSTEM){
-			return;
+			c_flush();
+			return 0;
 		}
 
 		if(*ibuf == I_NUM){ // Case the top includes line number
@@ -0,0 +1,183 @@
+/*
+	TOYOSHIKI Tiny BASIC for Linux
+	Benchmark harness
+	Build: cc -O2 bench/bench.c -o bench
+	Usage: bench [-n runs] [-s seed] [-c counter] [-o "options"] ttbasic file...
+
+	Runs ttbasic -r -s seed options file for each file, runs times, and
+	prints 1 JSON line per file:
+	  name     file name without directory and .bas
+	  wall_s   best wall time of the runs in seconds
+	  stmts    statements executed, by 1 run of counter(built with -DBENCH)
+	  stmts_s  stmts / wall_s
+	  peak_kb  largest peak resident memory of the runs in KB
+	  out      FNV-1a hash of stdout, the same in every build
+	  status   exit status of ttbasic, -1 if the outputs differ
+	bench/run.sh builds ttbasic, counter and this, and runs the .bas files here
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#define SIZE_ARGV 32 //Arguments to ttbasic
+
+// Result of 1 run
+typedef struct {
+	double wall; // seconds
+	long rss; // peak resident KB
+	unsigned int hash; // of stdout
+	unsigned long stmts; // STMTS line of stderr, 0 if none
+	int status; // exit status, -1 if killed or not run
+} result;
+
+char* opts[SIZE_ARGV]; //Options to ttbasic
+int optn; //Options count
+const char* seed = "1"; //Seed of RND
+
+// Read fd to the end, return FNV-1a hash
+unsigned int drain(int fd, unsigned int h, char* keep, int size) {
+	char buf[4096];
+	int n, i, k = 0;
+
+	while ((n = read(fd, buf, sizeof(buf))) > 0)
+		for (i = 0; i < n; i++) {
+			h = (h ^ (unsigned char)buf[i]) * 16777619u;
+			if (keep && k < size - 1)
+				keep[k++] = buf[i];
+		}
+	if (keep)
+		keep[k] = 0;
+	return h;
+}
+
+// Run bin on file once
+result run(const char* bin, const char* file) {
+	result r = {0, 0, 2166136261u, 0, -1};
+	char err[256];
+	char* argv[SIZE_ARGV + 6];
+	struct timespec t0, t1;
+	struct rusage ru;
+	int out[2], ers[2], st, i, n = 0;
+	char* s;
+	pid_t pid;
+
+	argv[n++] = (char*)bin;
+	argv[n++] = "-r";
+	argv[n++] = "-s";
+	argv[n++] = (char*)seed;
+	for (i = 0; i < optn; i++)
+		argv[n++] = opts[i];
+	argv[n++] = (char*)file;
+	argv[n] = NULL;
+
+	if (pipe(out) < 0 || pipe(ers) < 0)
+		return r;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	pid = fork();
+	if (pid < 0)
+		return r;
+	if (pid == 0) {
+		i = open("/dev/null", O_RDONLY);
+		dup2(i, 0);
+		dup2(out[1], 1);
+		dup2(ers[1], 2);
+		close(out[0]); close(out[1]);
+		close(ers[0]); close(ers[1]);
+		execv(bin, argv);
+		_exit(127);
+	}
+	close(out[1]);
+	close(ers[1]);
+	r.hash = drain(out[0], r.hash, NULL, 0);
+	drain(ers[0], 0, err, sizeof(err)); // small, fits in the pipe
+	close(out[0]);
+	close(ers[0]);
+	if (wait4(pid, &st, 0, &ru) < 0)
+		return r;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	r.wall = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	r.rss = ru.ru_maxrss;
+	r.status = WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+	if ((s = strstr(err, "STMTS ")))
+		r.stmts = strtoul(s + 6, NULL, 10);
+	return r;
+}
+
+// Print name of file without directory and .bas
+void putname(const char* file) {
+	const char* s;
+	int n;
+
+	s = strrchr(file, '/');
+	s = s ? s + 1 : file;
+	n = strlen(s);
+	if (n > 4 && !strcmp(s + n - 4, ".bas"))
+		n -= 4;
+	printf("%.*s", n, s);
+}
+
+int main(int argc, char** argv) {
+	const char* counter = NULL;
+	result r, best;
+	char* s;
+	int runs = 5, c, i, k;
+
+	while ((c = getopt(argc, argv, "n:s:c:o:")) != -1)
+		switch (c) {
+		case 'n':
+			runs = atoi(optarg);
+			break;
+		case 's':
+			seed = optarg;
+			break;
+		case 'c':
+			counter = optarg;
+			break;
+		case 'o': // split by spaces
+			for (s = strtok(optarg, " "); s && optn < SIZE_ARGV; s = strtok(NULL, " "))
+				opts[optn++] = s;
+			break;
+		default:
+			runs = 0;
+			break;
+		}
+	if (runs < 1 || argc - optind < 2) {
+		fprintf(stderr, "usage: %s [-n runs] [-s seed] [-c counter] [-o \"options\"] ttbasic file...\n", argv[0]);
+		return 1;
+	}
+
+	for (i = optind + 1; i < argc; i++) {
+		best = run(argv[optind], argv[i]);
+		for (k = 1; k < runs && best.status == 0; k++) {
+			r = run(argv[optind], argv[i]);
+			if (r.status != 0 || r.hash != best.hash)
+				best.status = r.status ? r.status : -1;
+			if (r.wall < best.wall)
+				best.wall = r.wall;
+			if (r.rss > best.rss)
+				best.rss = r.rss;
+		}
+		if (counter) {
+			r = run(counter, argv[i]);
+			best.stmts = r.stmts;
+			if (best.status == 0 && (r.status != 0 || r.hash != best.hash))
+				best.status = -1; // builds differ
+		}
+
+		printf("{\"name\":\"");
+		putname(argv[i]);
+		printf("\",\"wall_s\":%.6f,\"stmts\":%lu,\"stmts_s\":%.0f,"
+			"\"peak_kb\":%ld,\"out\":\"%08x\",\"status\":%d}\n",
+			best.wall, best.stmts, best.wall > 0 ? best.stmts / best.wall : 0,
+			best.rss, best.hash, best.status);
+		fflush(stdout);
+	}
+	return 0;
+}
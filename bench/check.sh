@@ -0,0 +1,35 @@
+#!/bin/sh
+# Check that every build gives the expected output of bench/check/*.in
+# Usage: bench/check.sh [case.in|case.sh...]
+# A case is piped to ttbasic as typed, case.opt has options to it if any,
+# or case.sh is run in an empty directory with the path of ttbasic,
+# case.exp is stdout, the exit status and stderr
+cd "$(dirname "$0")/.."
+CC=${CC:-cc}
+B=$(mktemp -d)
+trap 'rm -rf "$B"' EXIT
+[ $# -gt 0 ] || set -- bench/check/*.in bench/check/*.sh
+fail=0
+
+for f in "" -DNO_VM -DNO_JIT -DNO_ECACHE -DNO_THREADED; do
+	$CC -O2 $f ttbasic.c basic.c -o "$B/ttbasic" -pthread || exit 1
+	for c in "$@"; do
+		c=${c%.in}
+		c=${c%.sh}
+		if [ -f "$c.sh" ]; then
+			rm -rf "$B/d" && mkdir "$B/d"
+			(cd "$B/d" && sh "$OLDPWD/$c.sh" "$B/ttbasic") > "$B/out" 2> "$B/err"
+		else
+			"$B/ttbasic" $(cat "$c.opt" 2>/dev/null) < "$c.in" > "$B/out" 2> "$B/err"
+		fi
+		echo "status $?" >> "$B/out"
+		cat "$B/err" >> "$B/out"
+		if ! cmp -s "$B/out" "$c.exp"; then
+			echo "FAIL ${c##*/} ${f:-default}"
+			diff "$c.exp" "$B/out" | head -20
+			fail=1
+		fi
+	done
+done
+[ $fail = 0 ] && echo "ALL OK"
+exit $fail
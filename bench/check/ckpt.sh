@@ -0,0 +1,28 @@
+# CHECKPOINT, killed after it and resumed by -r -c, gives the output of
+# a run without a break, and the checkpoint file is removed at the end
+T=$1
+cat > ck.bas <<'E'
+10 FOR K=10 TO 40 STEP 10
+20 PRINT K
+30 IF K=20 CHECKPOINT; GOTO 60
+40 NEXT K
+50 STOP
+60 IF SIZE()<1000 GOTO 60
+70 GOTO 40
+E
+# -l 512 waits at 60 to be killed
+"$T" -r -l 512 -c ck.img ck.bas > o1.txt &
+p=$!
+i=0
+while [ ! -f ck.img ] && [ $i -lt 200 ]; do
+	sleep 0.05
+	i=$((i + 1))
+done
+kill -9 $p
+wait $p 2> /dev/null
+"$T" -r -l 4096 -c ck.img ck.bas > o2.txt
+echo "resume $?"
+[ -f ck.img ] && echo "ck.img is left"
+"$T" -r -l 4096 ck.bas > full.txt
+cat o1.txt o2.txt | cmp - full.txt && echo "same as full run"
+cat full.txt
@@ -0,0 +1,21 @@
+# LOAD text, SAVE the image, NEW, LOAD the image, LIST and RUN it, then
+# an image with a wrong magic, version or kwsum is not loaded
+T=$1
+cat > p.bas <<'E'
+10 A=3; @(1)=A*7
+20 PRINT "A",A,@(1)
+30 FOR I=1 TO 3
+40 PRINT I
+50 NEXT I
+E
+printf 'LOAD "p.bas"\nSAVE "p.img"\nNEW\nLIST\nLOAD "p.img"\nLIST\nRUN\n' |
+	"$T" | grep -v '^>*$'
+"$T" -r p.img
+echo "run $?"
+# byte at: 0 magic, 8 version, 12 kwsum
+for o in 0 8 12; do
+	cp p.img w.img
+	printf '\377' | dd of=w.img bs=1 seek=$o conv=notrunc 2> /dev/null
+	{ "$T" -r w.img; echo "at $o $?"; } 2>&1 |
+		tr -c '\n -~' '?' # a wrong magic is read as text
+done
@@ -0,0 +1,15 @@
+# -p runs a directory of jobs, b.in is the input of b.bas, -o keeps
+# .out and .err of each, and a JSON line tells the status of each
+T=$1
+mkdir jobs out
+printf '10 PRINT "A"\n' > jobs/a.bas
+printf '10 INPUT X\n20 PRINT X*2\n' > jobs/b.bas
+printf '21\n' > jobs/b.in
+printf '10 PRINT 1\n20 GOTO 99\n' > jobs/c.bas
+printf '10 PRINT 2\n' > 'jobs/d"\.bas' # escaped in JSON
+{ "$T" -p 2 -s 1 -o out jobs; echo "run $?"; } |
+	sed 's/"wall_s":[0-9.]*/"wall_s":T/; s/"jobs_s":[0-9.]*/"jobs_s":N/'
+for f in out/*; do
+	printf '%s:\n' "$f"
+	cat "$f"
+done
@@ -0,0 +1,14 @@
+10 REM Recursion emulated with GOSUB and a stack in @()
+20 FOR R=1 TO 300
+30 P=0; N=16; GOSUB 100
+40 NEXT R
+50 PRINT F
+60 STOP
+100 REM F=FIB(N), P is the stack pointer
+110 IF N<2 F=N; RETURN
+120 @(P)=N; P=P+1
+130 N=N-1; GOSUB 100
+140 @(P)=F; P=P+1
+150 N=@(P-2)-2; GOSUB 100
+160 P=P-1; F=F+@(P); P=P-1
+170 RETURN
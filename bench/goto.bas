@@ -0,0 +1,405 @@
+10 REM Large program with far GOTOs, constant and computed
+20 C=0; R=0
+30 R=R+1; IF R>8000 GOTO 60
+40 GOTO 2360
+60 PRINT C,R; STOP
+1000 C=C+1; GOTO 3780
+1010 C=C+1; G=3950; GOTO G
+1020 C=C+1; GOTO 4990
+1030 C=C+1; G=4430; GOTO G
+1040 C=C+1; GOTO 1350
+1050 C=C+1; G=4880; GOTO G
+1060 C=C+1; GOTO 2490
+1070 C=C+1; G=4780; GOTO G
+1080 C=C+1; GOTO 2040
+1090 C=C+1; G=3250; GOTO G
+1100 C=C+1; GOTO 2080
+1110 C=C+1; G=3380; GOTO G
+1120 C=C+1; GOTO 4770
+1130 C=C+1; G=2920; GOTO G
+1140 C=C+1; GOTO 4900
+1150 C=C+1; G=2270; GOTO G
+1160 C=C+1; GOTO 1990
+1170 C=C+1; G=1420; GOTO G
+1180 C=C+1; GOTO 1490
+1190 C=C+1; G=1390; GOTO G
+1200 C=C+1; GOTO 4660
+1210 C=C+1; G=4830; GOTO G
+1220 C=C+1; GOTO 1670
+1230 C=C+1; G=3490; GOTO G
+1240 C=C+1; GOTO 2820
+1250 C=C+1; G=2540; GOTO G
+1260 C=C+1; GOTO 3440
+1270 C=C+1; G=1340; GOTO G
+1280 C=C+1; GOTO 4060
+1290 C=C+1; G=2230; GOTO G
+1300 C=C+1; GOTO 1080
+1310 C=C+1; G=1540; GOTO G
+1320 C=C+1; GOTO 3840
+1330 C=C+1; G=3670; GOTO G
+1340 C=C+1; GOTO 3900
+1350 C=C+1; G=2290; GOTO G
+1360 C=C+1; GOTO 1580
+1370 C=C+1; G=4670; GOTO G
+1380 C=C+1; GOTO 1630
+1390 C=C+1; G=3590; GOTO G
+1400 C=C+1; GOTO 2440
+1410 C=C+1; G=3350; GOTO G
+1420 C=C+1; GOTO 1980
+1430 C=C+1; G=4560; GOTO G
+1440 C=C+1; GOTO 1880
+1450 C=C+1; G=4620; GOTO G
+1460 C=C+1; GOTO 2120
+1470 C=C+1; G=4930; GOTO G
+1480 C=C+1; GOTO 4500
+1490 C=C+1; G=4140; GOTO G
+1500 C=C+1; GOTO 4490
+1510 C=C+1; G=1600; GOTO G
+1520 C=C+1; GOTO 3540
+1530 C=C+1; G=1790; GOTO G
+1540 C=C+1; GOTO 3040
+1550 C=C+1; G=4640; GOTO G
+1560 C=C+1; GOTO 3830
+1570 C=C+1; G=3280; GOTO G
+1580 C=C+1; GOTO 3160
+1590 C=C+1; G=4570; GOTO G
+1600 C=C+1; GOTO 1570
+1610 C=C+1; G=2620; GOTO G
+1620 C=C+1; GOTO 1970
+1630 C=C+1; G=2860; GOTO G
+1640 C=C+1; GOTO 4450
+1650 C=C+1; G=3240; GOTO G
+1660 C=C+1; GOTO 2960
+1670 C=C+1; G=4580; GOTO G
+1680 C=C+1; GOTO 3360
+1690 C=C+1; G=2660; GOTO G
+1700 C=C+1; GOTO 3120
+1710 C=C+1; G=4200; GOTO G
+1720 C=C+1; GOTO 2600
+1730 C=C+1; G=2570; GOTO G
+1740 C=C+1; GOTO 1710
+1750 C=C+1; G=4790; GOTO G
+1760 C=C+1; GOTO 1660
+1770 C=C+1; G=2180; GOTO G
+1780 C=C+1; GOTO 1470
+1790 C=C+1; G=1750; GOTO G
+1800 C=C+1; GOTO 4260
+1810 C=C+1; G=4220; GOTO G
+1820 C=C+1; GOTO 3930
+1830 C=C+1; G=2970; GOTO G
+1840 C=C+1; GOTO 2610
+1850 C=C+1; G=1900; GOTO G
+1860 C=C+1; GOTO 4160
+1870 C=C+1; G=3430; GOTO G
+1880 C=C+1; GOTO 2780
+1890 C=C+1; G=3940; GOTO G
+1900 C=C+1; GOTO 1400
+1910 C=C+1; G=3690; GOTO G
+1920 C=C+1; GOTO 1760
+1930 C=C+1; G=1300; GOTO G
+1940 C=C+1; GOTO 2690
+1950 C=C+1; G=3550; GOTO G
+1960 C=C+1; GOTO 2810
+1970 C=C+1; G=3660; GOTO G
+1980 C=C+1; GOTO 4980
+1990 C=C+1; G=1510; GOTO G
+2000 C=C+1; GOTO 1060
+2010 C=C+1; G=1150; GOTO G
+2020 C=C+1; GOTO 2510
+2030 C=C+1; G=3720; GOTO G
+2040 C=C+1; GOTO 4470
+2050 C=C+1; G=1800; GOTO G
+2060 C=C+1; GOTO 2390
+2070 C=C+1; G=1280; GOTO G
+2080 C=C+1; GOTO 2790
+2090 C=C+1; G=1620; GOTO G
+2100 C=C+1; GOTO 2000
+2110 C=C+1; G=1040; GOTO G
+2120 C=C+1; GOTO 3750
+2130 C=C+1; G=4170; GOTO G
+2140 C=C+1; GOTO 2150
+2150 C=C+1; G=1860; GOTO G
+2160 C=C+1; GOTO 1240
+2170 C=C+1; G=3790; GOTO G
+2180 C=C+1; GOTO 3300
+2190 C=C+1; G=4530; GOTO G
+2200 C=C+1; GOTO 2380
+2210 C=C+1; G=4690; GOTO G
+2220 C=C+1; GOTO 2680
+2230 C=C+1; G=4540; GOTO G
+2240 C=C+1; GOTO 4050
+2250 C=C+1; G=3150; GOTO G
+2260 C=C+1; GOTO 4300
+2270 C=C+1; G=1130; GOTO G
+2280 C=C+1; GOTO 3470
+2290 C=C+1; G=3520; GOTO G
+2300 C=C+1; GOTO 2050
+2310 C=C+1; G=1220; GOTO G
+2320 C=C+1; GOTO 2720
+2330 C=C+1; G=2950; GOTO G
+2340 C=C+1; GOTO 1500
+2350 C=C+1; G=4740; GOTO G
+2360 C=C+1; GOTO 2210
+2370 C=C+1; G=3640; GOTO G
+2380 C=C+1; GOTO 4240
+2390 C=C+1; G=2300; GOTO G
+2400 C=C+1; GOTO 3800
+2410 C=C+1; G=4840; GOTO G
+2420 C=C+1; GOTO 1560
+2430 C=C+1; G=1180; GOTO G
+2440 C=C+1; GOTO 1010
+2450 C=C+1; G=3650; GOTO G
+2460 C=C+1; GOTO 2940
+2470 C=C+1; G=4150; GOTO G
+2480 C=C+1; GOTO 4480
+2490 C=C+1; G=2980; GOTO G
+2500 C=C+1; GOTO 4440
+2510 C=C+1; G=4870; GOTO G
+2520 C=C+1; GOTO 1230
+2530 C=C+1; G=2130; GOTO G
+2540 C=C+1; GOTO 4850
+2550 C=C+1; G=3400; GOTO G
+2560 C=C+1; GOTO 2520
+2570 C=C+1; G=2850; GOTO G
+2580 C=C+1; GOTO 2170
+2590 C=C+1; G=1840; GOTO G
+2600 C=C+1; GOTO 1320
+2610 C=C+1; G=1480; GOTO G
+2620 C=C+1; GOTO 2750
+2630 C=C+1; G=2200; GOTO G
+2640 C=C+1; GOTO 1870
+2650 C=C+1; G=4600; GOTO G
+2660 C=C+1; GOTO 2500
+2670 C=C+1; G=2640; GOTO G
+2680 C=C+1; GOTO 1190
+2690 C=C+1; G=3230; GOTO G
+2700 C=C+1; GOTO 1030
+2710 C=C+1; G=2140; GOTO G
+2720 C=C+1; GOTO 1050
+2730 C=C+1; G=2310; GOTO G
+2740 C=C+1; GOTO 2400
+2750 C=C+1; G=1940; GOTO G
+2760 C=C+1; GOTO 2910
+2770 C=C+1; G=2470; GOTO G
+2780 C=C+1; GOTO 3870
+2790 C=C+1; G=1810; GOTO G
+2800 C=C+1; GOTO 3070
+2810 C=C+1; G=3530; GOTO G
+2820 C=C+1; GOTO 2930
+2830 C=C+1; G=4110; GOTO G
+2840 C=C+1; GOTO 4520
+2850 C=C+1; G=1290; GOTO G
+2860 C=C+1; GOTO 1140
+2870 C=C+1; G=4400; GOTO G
+2880 C=C+1; GOTO 2990
+2890 C=C+1; G=4120; GOTO G
+2900 C=C+1; GOTO 3580
+2910 C=C+1; G=1550; GOTO G
+2920 C=C+1; GOTO 1720
+2930 C=C+1; G=3760; GOTO G
+2940 C=C+1; GOTO 3890
+2950 C=C+1; G=2450; GOTO G
+2960 C=C+1; GOTO 4710
+2970 C=C+1; G=1250; GOTO G
+2980 C=C+1; GOTO 2420
+2990 C=C+1; G=4040; GOTO G
+3000 C=C+1; GOTO 3340
+3010 C=C+1; G=2320; GOTO G
+3020 C=C+1; GOTO 3460
+3030 C=C+1; G=3140; GOTO G
+3040 C=C+1; GOTO 4610
+3050 C=C+1; G=1100; GOTO G
+3060 C=C+1; GOTO 30
+3070 C=C+1; G=4460; GOTO G
+3080 C=C+1; GOTO 1000
+3090 C=C+1; G=1590; GOTO G
+3100 C=C+1; GOTO 4360
+3110 C=C+1; G=1740; GOTO G
+3120 C=C+1; GOTO 4680
+3130 C=C+1; G=2530; GOTO G
+3140 C=C+1; GOTO 1020
+3150 C=C+1; G=1920; GOTO G
+3160 C=C+1; GOTO 2740
+3170 C=C+1; G=2250; GOTO G
+3180 C=C+1; GOTO 2890
+3190 C=C+1; G=4080; GOTO G
+3200 C=C+1; GOTO 3910
+3210 C=C+1; G=2260; GOTO G
+3220 C=C+1; GOTO 2100
+3230 C=C+1; G=2630; GOTO G
+3240 C=C+1; GOTO 3370
+3250 C=C+1; G=3610; GOTO G
+3260 C=C+1; GOTO 4950
+3270 C=C+1; G=3680; GOTO G
+3280 C=C+1; GOTO 2840
+3290 C=C+1; G=4070; GOTO G
+3300 C=C+1; GOTO 4010
+3310 C=C+1; G=3290; GOTO G
+3320 C=C+1; GOTO 2800
+3330 C=C+1; G=1610; GOTO G
+3340 C=C+1; GOTO 1770
+3350 C=C+1; G=1650; GOTO G
+3360 C=C+1; GOTO 3420
+3370 C=C+1; G=4890; GOTO G
+3380 C=C+1; GOTO 3310
+3390 C=C+1; G=2710; GOTO G
+3400 C=C+1; GOTO 4820
+3410 C=C+1; G=4320; GOTO G
+3420 C=C+1; GOTO 1830
+3430 C=C+1; G=4330; GOTO G
+3440 C=C+1; GOTO 4340
+3450 C=C+1; G=2240; GOTO G
+3460 C=C+1; GOTO 3850
+3470 C=C+1; G=3130; GOTO G
+3480 C=C+1; GOTO 3200
+3490 C=C+1; G=2220; GOTO G
+3500 C=C+1; GOTO 2410
+3510 C=C+1; G=3740; GOTO G
+3520 C=C+1; GOTO 4370
+3530 C=C+1; G=4970; GOTO G
+3540 C=C+1; GOTO 1850
+3550 C=C+1; G=1310; GOTO G
+3560 C=C+1; GOTO 2090
+3570 C=C+1; G=4910; GOTO G
+3580 C=C+1; GOTO 3560
+3590 C=C+1; G=2550; GOTO G
+3600 C=C+1; GOTO 3620
+3610 C=C+1; G=3390; GOTO G
+3620 C=C+1; GOTO 1640
+3630 C=C+1; G=3090; GOTO G
+3640 C=C+1; GOTO 4650
+3650 C=C+1; G=4800; GOTO G
+3660 C=C+1; GOTO 2460
+3670 C=C+1; G=2560; GOTO G
+3680 C=C+1; GOTO 2110
+3690 C=C+1; G=3710; GOTO G
+3700 C=C+1; GOTO 1170
+3710 C=C+1; G=4270; GOTO G
+3720 C=C+1; GOTO 4280
+3730 C=C+1; G=3410; GOTO G
+3740 C=C+1; GOTO 1270
+3750 C=C+1; G=2830; GOTO G
+3760 C=C+1; GOTO 4350
+3770 C=C+1; G=3260; GOTO G
+3780 C=C+1; GOTO 2880
+3790 C=C+1; G=4190; GOTO G
+3800 C=C+1; GOTO 4290
+3810 C=C+1; G=4510; GOTO G
+3820 C=C+1; GOTO 4130
+3830 C=C+1; G=2020; GOTO G
+3840 C=C+1; GOTO 1160
+3850 C=C+1; G=2160; GOTO G
+3860 C=C+1; GOTO 2330
+3870 C=C+1; G=1530; GOTO G
+3880 C=C+1; GOTO 1450
+3890 C=C+1; G=3920; GOTO G
+3900 C=C+1; GOTO 3960
+3910 C=C+1; G=4020; GOTO G
+3920 C=C+1; GOTO 1210
+3930 C=C+1; G=2480; GOTO G
+3940 C=C+1; GOTO 1070
+3950 C=C+1; G=4730; GOTO G
+3960 C=C+1; GOTO 1950
+3970 C=C+1; G=2730; GOTO G
+3980 C=C+1; GOTO 4000
+3990 C=C+1; G=3100; GOTO G
+4000 C=C+1; GOTO 1330
+4010 C=C+1; G=1890; GOTO G
+4020 C=C+1; GOTO 2650
+4030 C=C+1; G=4410; GOTO G
+4040 C=C+1; GOTO 3630
+4050 C=C+1; G=4920; GOTO G
+4060 C=C+1; GOTO 3730
+4070 C=C+1; G=1460; GOTO G
+4080 C=C+1; GOTO 2370
+4090 C=C+1; G=4940; GOTO G
+4100 C=C+1; GOTO 1930
+4110 C=C+1; G=2670; GOTO G
+4120 C=C+1; GOTO 3820
+4130 C=C+1; G=3510; GOTO G
+4140 C=C+1; GOTO 3220
+4150 C=C+1; G=1370; GOTO G
+4160 C=C+1; GOTO 3570
+4170 C=C+1; G=4380; GOTO G
+4180 C=C+1; GOTO 4420
+4190 C=C+1; G=3700; GOTO G
+4200 C=C+1; GOTO 1090
+4210 C=C+1; G=3030; GOTO G
+4220 C=C+1; GOTO 2280
+4230 C=C+1; G=1780; GOTO G
+4240 C=C+1; GOTO 2070
+4250 C=C+1; G=2700; GOTO G
+4260 C=C+1; GOTO 4030
+4270 C=C+1; G=1700; GOTO G
+4280 C=C+1; GOTO 3080
+4290 C=C+1; G=2900; GOTO G
+4300 C=C+1; GOTO 4960
+4310 C=C+1; G=4630; GOTO G
+4320 C=C+1; GOTO 3110
+4330 C=C+1; G=3330; GOTO G
+4340 C=C+1; GOTO 4590
+4350 C=C+1; G=3060; GOTO G
+4360 C=C+1; GOTO 1430
+4370 C=C+1; G=3000; GOTO G
+4380 C=C+1; GOTO 1200
+4390 C=C+1; G=4100; GOTO G
+4400 C=C+1; GOTO 4550
+4410 C=C+1; G=4180; GOTO G
+4420 C=C+1; GOTO 4210
+4430 C=C+1; G=1690; GOTO G
+4440 C=C+1; GOTO 4310
+4450 C=C+1; G=1910; GOTO G
+4460 C=C+1; GOTO 3770
+4470 C=C+1; G=2340; GOTO G
+4480 C=C+1; GOTO 2580
+4490 C=C+1; G=2430; GOTO G
+4500 C=C+1; GOTO 4720
+4510 C=C+1; G=3600; GOTO G
+4520 C=C+1; GOTO 3270
+4530 C=C+1; G=1680; GOTO G
+4540 C=C+1; GOTO 2010
+4550 C=C+1; G=4090; GOTO G
+4560 C=C+1; GOTO 3860
+4570 C=C+1; G=1730; GOTO G
+4580 C=C+1; GOTO 3210
+4590 C=C+1; G=2350; GOTO G
+4600 C=C+1; GOTO 4760
+4610 C=C+1; G=4230; GOTO G
+4620 C=C+1; GOTO 4860
+4630 C=C+1; G=1360; GOTO G
+4640 C=C+1; GOTO 1110
+4650 C=C+1; G=3880; GOTO G
+4660 C=C+1; GOTO 2590
+4670 C=C+1; G=3190; GOTO G
+4680 C=C+1; GOTO 1820
+4690 C=C+1; G=3010; GOTO G
+4700 C=C+1; GOTO 2770
+4710 C=C+1; G=4750; GOTO G
+4720 C=C+1; GOTO 3170
+4730 C=C+1; G=2060; GOTO G
+4740 C=C+1; GOTO 4250
+4750 C=C+1; G=4700; GOTO G
+4760 C=C+1; GOTO 3500
+4770 C=C+1; G=1260; GOTO G
+4780 C=C+1; GOTO 3970
+4790 C=C+1; G=3980; GOTO G
+4800 C=C+1; GOTO 3050
+4810 C=C+1; G=2190; GOTO G
+4820 C=C+1; GOTO 1410
+4830 C=C+1; G=3320; GOTO G
+4840 C=C+1; GOTO 3020
+4850 C=C+1; G=3990; GOTO G
+4860 C=C+1; GOTO 3450
+4870 C=C+1; G=1120; GOTO G
+4880 C=C+1; GOTO 1960
+4890 C=C+1; G=2030; GOTO G
+4900 C=C+1; GOTO 3480
+4910 C=C+1; G=3180; GOTO G
+4920 C=C+1; GOTO 2870
+4930 C=C+1; G=3810; GOTO G
+4940 C=C+1; GOTO 2760
+4950 C=C+1; G=1380; GOTO G
+4960 C=C+1; GOTO 4810
+4970 C=C+1; G=1440; GOTO G
+4980 C=C+1; GOTO 1520
+4990 C=C+1; G=4390; GOTO G
@@ -0,0 +1,13 @@
+10 REM Nested FOR/NEXT arithmetic
+20 S=0
+25 FOR R=1 TO 10
+30 FOR I=1 TO 150
+40 FOR J=1 TO 150
+50 S=S+I*J/7-J*3
+60 IF S>10000 S=S-10000
+70 IF S<-10000 S=S+10000
+80 NEXT J
+90 FOR K=150 TO 1 STEP -3; S=S+(K-I)/2; NEXT K
+100 NEXT I
+105 NEXT R
+110 PRINT S
@@ -0,0 +1,5 @@
+10 REM PRINT-heavy output
+20 FOR I=1 TO 20000
+30 PRINT I," ",I/7*3," ",RND(1000),"  LINE OF TEXT FOR OUTPUT"
+40 PRINT #8,I,-I,#3,I/100; PRINT 'QUOTED',"DOUBLE"
+50 NEXT I
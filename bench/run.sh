@@ -0,0 +1,21 @@
+#!/bin/sh
+# Build ttbasic, the counting build and the harness, and run bench/*.bas
+# Usage: bench/run.sh [runs] [file...]
+# CC, CFLAGS build ttbasic(e.g. CFLAGS=-DNO_JIT), BENCHOPT are options to it
+# Prints 1 JSON line per file, see bench/bench.c, then 1 of the tokenizer
+# with the same CFLAGS, see bench/tok.c
+set -e
+cd "$(dirname "$0")/.."
+CC=${CC:-cc}
+RUNS=${1:-5}
+[ $# -gt 0 ] && shift
+[ $# -gt 0 ] || set -- bench/*.bas
+B=$(mktemp -d)
+trap 'rm -rf "$B"' EXIT
+
+$CC -O2 $CFLAGS ttbasic.c basic.c -o "$B/ttbasic" -pthread
+$CC -O2 -DBENCH ttbasic.c basic.c -o "$B/count" -pthread
+$CC -O2 bench/bench.c -o "$B/bench"
+$CC -O2 $CFLAGS bench/tok.c -o "$B/tok" -pthread
+"$B/bench" -n "$RUNS" -c "$B/count" -o "${BENCHOPT:--l 32767 -a 8192 -g 64 -f 8}" "$B/ttbasic" "$@"
+"$B/tok" -r "$RUNS"
@@ -0,0 +1,12 @@
+10 REM Sieve of Eratosthenes in @(), 200 times
+20 N=4000
+30 FOR R=1 TO 200
+40 FOR I=0 TO N-1; @(I)=1; NEXT I
+50 C=0
+60 FOR I=2 TO N-1
+70 IF @(I)=0 GOTO 100
+80 C=C+1
+90 IF I+I<N FOR J=I+I TO N-1 STEP I; @(J)=0; NEXT J
+100 NEXT I
+110 NEXT R
+120 PRINT C
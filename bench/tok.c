@@ -0,0 +1,112 @@
+/*
+	TOYOSHIKI Tiny BASIC for Linux
+	Tokenizer benchmark
+	Build: cc -O2 bench/tok.c -o tok -pthread
+	Usage: tok [-n lines] [-r rounds] [file...]
+
+	Converts the lines of the files(or n generated lines) by toktoi()
+	rounds times, and prints 1 JSON line:
+	  lines    lines converted in a round
+	  bytes    bytes of them
+	  wall_s   best wall time of a round in seconds
+	  lines_s  lines / wall_s
+	  mb_s     bytes / wall_s in MB
+	  icode    FNV-1a hash of the i-code, the same if the tokenizer is
+	           changed without changing its output
+	bench/run.sh runs it with the generated lines
+*/
+
+#include "../basic.c"
+
+#define SIZE_LINES 65536 //Lines at most
+
+// Generated lines, keywords glued and spaced, both cases
+const char* gen[] = {
+	"10 FOR I=1 TO 100 STEP 2; GOSUB 200; NEXT I",
+	"20 forj=10to1step-1;print j,\"#\";next j",
+	"30 IF A>=B IF C<=D IF E#F GOTO 1000",
+	"40 LET @(I+1)=ABS(RND(100)-50)*SIZE/3",
+	"50 PRINT \"THE QUICK BROWN FOX\",#5,X;INPUT Y",
+	"60 REM a long comment that is copied to the list as it is",
+	"70 ifx<yx=y;ify>zy=z;return",
+	"80 A=(B+C)*(D-E)/(F+1);B=-A;C=A>B;D=A<B;E=A=B",
+	"90 GOSUB 9000; TRON; TROFF; STOP",
+	"100 print 'single','quoted';print 12345,-32767",
+};
+
+char* lines[SIZE_LINES]; //Lines to convert
+int nline; //Line count
+
+// Add lines of a file
+void addfile(const char* name) {
+	FILE* f;
+	char s[256];
+
+	f = fopen(name, "r");
+	if (f == NULL) {
+		fprintf(stderr, "%s: not found\n", name);
+		exit(1);
+	}
+	while (nline < SIZE_LINES && fgets(s, sizeof(s), f)) {
+		s[strcspn(s, "\r\n")] = 0;
+		if (*s)
+			lines[nline++] = strdup(s);
+	}
+	fclose(f);
+}
+
+int main(int argc, char** argv) {
+	unsigned long long t, best = ~0ULL;
+	unsigned long bytes = 0;
+	unsigned int hash = 0;
+	int rounds = 20, n = 10000, c, i, k;
+	unsigned char len;
+
+	while ((c = getopt(argc, argv, "n:r:")) != -1)
+		switch (c) {
+		case 'n':
+			n = atoi(optarg);
+			break;
+		case 'r':
+			rounds = atoi(optarg);
+			break;
+		default:
+			rounds = 0;
+			break;
+		}
+	if (rounds < 1 || n < 1 || n > SIZE_LINES) {
+		fprintf(stderr, "usage: %s [-n lines] [-r rounds] [file...]\n", argv[0]);
+		return 1;
+	}
+	for (i = optind; i < argc; i++)
+		addfile(argv[i]);
+	if (optind == argc)
+		for (nline = 0; nline < n; nline++)
+			lines[nline] = (char*)gen[nline % (sizeof(gen) / sizeof(gen[0]))];
+	hash = 2166136261u;
+	for (i = 0; i < nline; i++) {
+		bytes += strlen(lines[i]);
+		len = toktoi(lines[i]);
+		if (err)
+			len = err = 0;
+		for (c = 0; c < len; c++)
+			hash = (hash ^ ibuf[c]) * 16777619u;
+	}
+
+	for (k = 0; k < rounds; k++) {
+		t = c_nsec();
+		for (i = 0; i < nline; i++) {
+			toktoi(lines[i]);
+			err = 0;
+		}
+		t = c_nsec() - t;
+		if (t < best)
+			best = t;
+	}
+
+	printf("{\"name\":\"tok\",\"lines\":%d,\"bytes\":%lu,\"wall_s\":%.6f,"
+		"\"lines_s\":%.0f,\"mb_s\":%.1f,\"icode\":\"%08x\"}\n",
+		nline, bytes, best / 1e9, nline / (best / 1e9),
+		bytes / (best / 1e9) / 1e6, hash);
+	return 0;
+}
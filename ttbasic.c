@@ -1,16 +1,16 @@
 /*
 	TOYOSHIKI Tiny BASIC for Linux
 	(C)2015 Tetsuya Suzuki
-	Build: cc ttbasic.c basic.c -o ttbasic
+	Build: cc ttbasic.c basic.c -o ttbasic -pthread
+	(add -DNUM_BITS=32 -fwrapv or -DNUM_BITS=64 -fwrapv for wider values)
 */
 
 #include <stdlib.h>
 #include <time.h>
 
-void basic(void); // prototype
+int basic(int argc, char** argv); // prototype
 
-int main(){
+int main(int argc, char** argv){
 	srand((unsigned int)time(0)); // for RND function
-	basic(); // call The BASIC
-	return 0;
+	return basic(argc, argv); // call The BASIC, with options and a file to LOAD
 }